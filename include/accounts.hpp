@@ -15,6 +15,7 @@
 #include "money.hpp"
 #include "date.hpp"
 #include "writer_fwd.hpp"
+#include "month_index.hpp"
 
 namespace budget {
 
@@ -52,19 +53,26 @@ bool account_exists(const std::string& account);
 std::vector<std::string> all_account_names();
 
 std::vector<budget::account>& all_accounts();
-std::vector<budget::account>  all_accounts(year year, month month);
-std::vector<budget::account>  current_accounts();
+
+/*!
+ * \brief Returns a view of the accounts valid in the given month. The view
+ * is only valid until the accounts are modified.
+ */
+month_view<budget::account> all_accounts(year year, month month);
+month_view<budget::account> current_accounts();
 
 budget::account& get_account(size_t id);
 budget::account& get_account(std::string name, year year, month month);
 
 void set_accounts_changed();
 void set_accounts_next_id(size_t next_id);
+size_t accounts_generation();
 
 void show_all_accounts(budget::writer& w);
 void show_accounts(budget::writer& w);
 
 void add_account(account&& account);
+bool edit_account(account& account);
 bool account_exists(size_t id);
 void account_delete(size_t id);
 account& account_get(size_t id);
@@ -20,5 +20,6 @@ struct api_response {
 
 api_response api_get(const std::string& api, bool silent = false);
 api_response api_post(const std::string& api, const std::map<std::string, std::string>& params);
+api_response api_post(const std::string& api, const std::string& content, const char* content_type);
 
 } //end of namespace budget
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <memory>
+#include <functional>
 #include <vector>
 #include <string>
 #include <map>
@@ -60,6 +62,31 @@ struct asset_value {
     std::map<std::string, std::string> get_params();
 };
 
+/*!
+ * \brief The value of the assets, in the default currency, once all the
+ * asset values of a given date have been set.
+ */
+struct net_worth_point {
+    budget::date date;
+    budget::money net_worth;
+    budget::money portfolio;
+    budget::money cash;
+};
+
+/*!
+ * \brief Several sums of asset values over time, with one point for each
+ * date at which asset values have been set, sorted by date.
+ */
+struct asset_series {
+    std::vector<budget::date> dates;                   ///< The date of each point
+    std::vector<std::vector<budget::money>> values;    ///< The points of each serie
+};
+
+/*!
+ * \brief The weight of an asset in a serie, between 0 and 1
+ */
+using asset_weight = std::function<float(const asset& asset, size_t serie)>;
+
 std::ostream& operator<<(std::ostream& stream, const asset& asset);
 void operator>>(const std::vector<std::string>& parts, asset& asset);
 
@@ -90,7 +117,11 @@ std::vector<budget::asset_value>& all_asset_values();
 std::vector<budget::asset_value> all_sorted_asset_values();
 
 void set_assets_next_id(size_t next_id);
+size_t assets_generation();
 void set_asset_values_next_id(size_t next_id);
+size_t asset_values_generation();
+void begin_asset_values_batch();
+bool commit_asset_values_batch();
 
 void set_assets_changed();
 void set_asset_values_changed();
@@ -98,11 +129,13 @@ void set_asset_values_changed();
 std::string get_default_currency();
 
 void add_asset(asset&& asset);
+bool edit_asset(asset& asset);
 bool asset_exists(size_t id);
 void asset_delete(size_t id);
 asset& asset_get(size_t id);
 
 void add_asset_value(asset_value&& asset_value);
+bool edit_asset_value(asset_value& asset_value);
 bool asset_value_exists(size_t id);
 void asset_value_delete(size_t id);
 asset_value& asset_value_get(size_t id);
@@ -113,6 +146,26 @@ budget::money get_net_worth_cash();
 
 budget::money get_net_worth(budget::date d);
 
+/*!
+ * \brief Returns the evolution of the net worth, with one point for each
+ * date at which an asset value has been set, sorted by date.
+ *
+ * The returned timeline is an immutable snapshot, it stays valid even if
+ * the timeline is recomputed in the meantime.
+ */
+std::shared_ptr<const std::vector<net_worth_point>> net_worth_timeline();
+
+/*!
+ * \brief Compute count series over time. In each serie, the value of an
+ * asset is its latest value, in the default currency, multiplied by its
+ * weight in the serie.
+ *
+ * The assets, their weights and the exchange rates are resolved once per
+ * asset and the sums are updated with the difference of each new value,
+ * so this is linear in the number of asset values (after sorting them).
+ */
+asset_series compute_asset_series(size_t count, const asset_weight& weight);
+
 // Filter functions
 
 inline auto all_user_assets() {
@@ -0,0 +1,289 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <limits>
+
+#include "money.hpp"
+#include "date.hpp"
+
+namespace budget {
+
+/*
+ * Binary columnar storage for transaction-like modules (expenses and
+ * earnings), enabled with binary_storage=true in the configuration.
+ *
+ * Layout (host byte order):
+ *   header:   magic (8 bytes), version (u32), reserved (u32), count (u64), next_id (u64)
+ *   columns:  ids (u64[count]), accounts (u64[count]), amounts (i64[count]),
+ *             dates (u32[count], packed as year << 16 | month << 8 | day),
+ *             guid offsets (u32[count + 1]), name offsets (u32[count + 1])
+ *   strings:  all the guids, then all the names, without separators
+ */
+
+constexpr const char columnar_magic[8] = {'B', 'U', 'D', 'G', 'E', 'T', 'C', 'O'};
+constexpr const uint32_t columnar_version = 1;
+
+/*!
+ * \brief Indicates if a type can be stored in the columnar format. The
+ * type must have id, guid, date, name, account and amount fields.
+ */
+template<typename T>
+struct columnar_traits {
+    static constexpr const bool enabled = false;
+};
+
+/*!
+ * \brief A read-only view of a file, memory-mapped when possible.
+ */
+struct mapped_file {
+    explicit mapped_file(const std::string& path);
+    ~mapped_file();
+
+    mapped_file(const mapped_file& rhs) = delete;
+    mapped_file& operator=(const mapped_file& rhs) = delete;
+
+    bool valid() const {
+        return content != nullptr;
+    }
+
+    const char* begin() const {
+        return content;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+    const char* content = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+};
+
+namespace columnar_detail {
+
+inline uint32_t pack_date(const budget::date& d) {
+    return uint32_t(d.year()) << 16 | uint32_t(d.month()) << 8 | uint32_t(d.day());
+}
+
+inline budget::date unpack_date(uint32_t packed) {
+    return {date_type(packed >> 16), date_type((packed >> 8) & 0xFF), date_type(packed & 0xFF)};
+}
+
+template<typename V>
+void write_column(std::ostream& stream, const std::vector<V>& column) {
+    stream.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(V));
+}
+
+/*!
+ * \brief Sequential reader over the mapped file, checking bounds.
+ */
+struct reader {
+    const char* first;
+    const char* last;
+
+    bool can_read(size_t bytes) const {
+        return size_t(last - first) >= bytes;
+    }
+
+    template<typename V>
+    V read() {
+        V value;
+        std::memcpy(&value, first, sizeof(V));
+        first += sizeof(V);
+        return value;
+    }
+
+    template<typename V>
+    const char* column(size_t count) {
+        auto start = first;
+        first += count * sizeof(V);
+        return start;
+    }
+};
+
+template<typename V>
+V at(const char* column, size_t i) {
+    V value;
+    std::memcpy(&value, column + i * sizeof(V), sizeof(V));
+    return value;
+}
+
+} //end of namespace columnar_detail
+
+/*!
+ * \brief Save the given entries to the file in the columnar format
+ * \return true if the file was written, false otherwise
+ */
+template<typename T>
+bool columnar_save(const std::string& path, const std::vector<T>& data, size_t next_id) {
+    using namespace columnar_detail;
+
+    const size_t count = data.size();
+
+    std::vector<uint64_t> ids(count);
+    std::vector<uint64_t> accounts(count);
+    std::vector<int64_t> amounts(count);
+    std::vector<uint32_t> dates(count);
+    std::vector<uint32_t> guid_offsets(count + 1);
+    std::vector<uint32_t> name_offsets(count + 1);
+
+    std::string strings;
+
+    for (size_t i = 0; i < count; ++i) {
+        auto& entry = data[i];
+
+        ids[i]      = entry.id;
+        accounts[i] = entry.account;
+        amounts[i]  = entry.amount.value;
+        dates[i]    = pack_date(entry.date);
+
+        guid_offsets[i] = strings.size();
+        strings += entry.guid;
+    }
+
+    guid_offsets[count] = strings.size();
+
+    for (size_t i = 0; i < count; ++i) {
+        name_offsets[i] = strings.size();
+        strings += data[i].name;
+    }
+
+    name_offsets[count] = strings.size();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    uint32_t version  = columnar_version;
+    uint32_t reserved = 0;
+    uint64_t size     = count;
+    uint64_t next     = next_id;
+
+    file.write(columnar_magic, sizeof(columnar_magic));
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    file.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+    file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    file.write(reinterpret_cast<const char*>(&next), sizeof(next));
+
+    write_column(file, ids);
+    write_column(file, accounts);
+    write_column(file, amounts);
+    write_column(file, dates);
+    write_column(file, guid_offsets);
+    write_column(file, name_offsets);
+
+    file.write(strings.data(), strings.size());
+
+    return file.good();
+}
+
+/*!
+ * \brief Load the entries from the file in the columnar format.
+ * \return true if the file was loaded, false if it does not exist or is invalid
+ */
+template<typename T>
+bool columnar_load(const std::string& path, std::vector<T>& data, size_t& next_id) {
+    using namespace columnar_detail;
+
+    mapped_file file(path);
+
+    if (!file.valid()) {
+        return false;
+    }
+
+    reader r{file.begin(), file.begin() + file.size()};
+
+    if (!r.can_read(sizeof(columnar_magic) + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t))) {
+        return false;
+    }
+
+    if (std::memcmp(r.first, columnar_magic, sizeof(columnar_magic)) != 0) {
+        return false;
+    }
+
+    r.first += sizeof(columnar_magic);
+
+    auto version = r.read<uint32_t>();
+    r.read<uint32_t>();
+
+    if (version != columnar_version) {
+        return false;
+    }
+
+    auto count = r.read<uint64_t>();
+    auto next  = r.read<uint64_t>();
+
+    const size_t row_bytes = 3 * sizeof(uint64_t) + 3 * sizeof(uint32_t);
+
+    // The count comes from the file, the size of the columns must not overflow
+    if (count > (std::numeric_limits<size_t>::max() - 2 * sizeof(uint32_t)) / row_bytes) {
+        return false;
+    }
+
+    if (!r.can_read(count * row_bytes + 2 * sizeof(uint32_t))) {
+        return false;
+    }
+
+    auto ids          = r.column<uint64_t>(count);
+    auto accounts     = r.column<uint64_t>(count);
+    auto amounts      = r.column<int64_t>(count);
+    auto dates        = r.column<uint32_t>(count);
+    auto guid_offsets = r.column<uint32_t>(count + 1);
+    auto name_offsets = r.column<uint32_t>(count + 1);
+    auto strings      = r.first;
+
+    // The guids are followed by the names, the offsets must be increasing
+    // and inside the strings
+    if (at<uint32_t>(guid_offsets, 0) != 0 || at<uint32_t>(guid_offsets, count) != at<uint32_t>(name_offsets, 0)) {
+        return false;
+    }
+
+    if (!r.can_read(at<uint32_t>(name_offsets, count))) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (at<uint32_t>(guid_offsets, i) > at<uint32_t>(guid_offsets, i + 1) || at<uint32_t>(name_offsets, i) > at<uint32_t>(name_offsets, i + 1)) {
+            return false;
+        }
+    }
+
+    data.reserve(data.size() + count);
+
+    for (size_t i = 0; i < count; ++i) {
+        T entry;
+
+        entry.id           = at<uint64_t>(ids, i);
+        entry.account      = at<uint64_t>(accounts, i);
+        entry.amount.value = at<int64_t>(amounts, i);
+        entry.date         = unpack_date(at<uint32_t>(dates, i));
+
+        auto guid_first = at<uint32_t>(guid_offsets, i);
+        auto name_first = at<uint32_t>(name_offsets, i);
+
+        entry.guid.assign(strings + guid_first, at<uint32_t>(guid_offsets, i + 1) - guid_first);
+        entry.name.assign(strings + name_first, at<uint32_t>(name_offsets, i + 1) - name_first);
+
+        data.push_back(std::move(entry));
+    }
+
+    next_id = next;
+
+    return true;
+}
+
+} //end of namespace budget
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "money.hpp"
 #include "date.hpp"
 
@@ -18,7 +20,7 @@ struct status {
     budget::money budget;
     budget::money balance;
 
-    status add_expense(budget::money expense){
+    status add_expense(budget::money expense) const {
         auto new_status = *this;
 
         new_status.expenses += expense;
@@ -27,7 +29,7 @@ struct status {
         return std::move(new_status);
     }
 
-    status add_earning(budget::money earning){
+    status add_earning(budget::money earning) const {
         auto new_status = *this;
 
         new_status.earnings += earning;
@@ -45,6 +47,12 @@ status compute_month_status();
 status compute_month_status(budget::month year);
 status compute_month_status(budget::year year, budget::month month);
 
+/*!
+ * \brief Compute the status of each month from the month of from to the
+ * month of to (included), in one pass over the data.
+ */
+std::vector<status> compute_monthly_statuses(budget::date from, budget::date to);
+
 status compute_avg_month_status();
 status compute_avg_month_status(budget::month year);
 status compute_avg_month_status(budget::year year, budget::month month);
@@ -59,6 +59,12 @@ bool is_server_ssl();
  */
 bool is_fortune_disabled();
 
+/*!
+ * \brief Indicates if the modules supporting it are stored in the
+ * binary columnar format instead of text.
+ */
+bool is_binary_storage();
+
 /*!
  * \brief Indicates if net worth should be used instead of fortune
  * for computation.
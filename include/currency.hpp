@@ -11,9 +11,39 @@
 
 namespace budget {
 
+/*!
+ * \brief Statistics about the usage of the exchange rates cache
+ */
+struct currency_cache_stats {
+    size_t hits            = 0; ///< Number of rates found in the cache
+    size_t misses          = 0; ///< Number of rates not found in the cache
+    size_t refreshes       = 0; ///< Number of complete refreshes of the cache
+    double last_refresh_ms = 0; ///< Duration of the last refresh
+    double total_refresh_ms = 0; ///< Duration of all the refreshes
+};
+
+/*!
+ * \brief Returns the exchange rate between the two currencies.
+ *
+ * The rates are cached on disk. When the server is running, a rate that is
+ * not in the cache is fetched in the background and 1.0 is returned in the
+ * meantime, so that pages are never blocked by the exchange service.
+ */
 double exchange_rate(const std::string& from);
 double exchange_rate(const std::string& from, const std::string& to);
 
-void invalidate_currency_cache();
+/*!
+ * \brief Fetch again all the exchange rates that are in the cache.
+ */
+void refresh_currency_cache();
+
+currency_cache_stats currency_cache_statistics();
+
+/*!
+ * \brief Returns a counter that is incremented each time the rates of the
+ * currency cache change: when a rate is fetched in the background and
+ * after each refresh.
+ */
+size_t currency_cache_generation();
 
 } //end of namespace budget
@@ -7,22 +7,62 @@
 
 #pragma once
 
+#include <unordered_map>
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <fstream>
+#include <mutex>
+#include <algorithm>
+
 #include "cpp_utils/assert.hpp"
 
 #include "config.hpp"
 #include "utils.hpp"
 #include "server.hpp"
 #include "api.hpp"
+#include "columnar.hpp"
+#include "loader.hpp"
 
 namespace budget {
 
+/*!
+ * \brief Number of records after which the journal of a module is
+ * compacted into its data file.
+ */
+constexpr const size_t journal_compaction_threshold = 1000;
+
+/*!
+ * \brief The kind of modification of a single entry
+ */
+enum class data_change {
+    added,  ///< The entry has been appended
+    edited, ///< The entry has been modified in place
+    erased  ///< The entry has been erased, the next entries moved down
+};
+
 template<typename T>
-struct data_handler {
+struct data_handler : module_endpoint {
     size_t next_id;
     std::vector<T> data;
 
-    data_handler(const char* module, const char* path) : module(module), path(path) {
-        // Nothing else to init
+    using reference_checker = bool (*)(const T& entry, std::string& error);
+    using change_listener   = void (*)(const std::vector<T>& data, size_t generation, data_change change, size_t position);
+
+    /*!
+     * \brief Construct the handler of a module. The data is only loaded the
+     * first time it is accessed. If given, on_load is called each time the
+     * data has been loaded (after all the data when loading concurrently).
+     * If given, check_references is used to reject the mutations whose
+     * entries reference entries of other modules that do not exist.
+     * If given, on_change is called after each entry added, edited or
+     * removed with add(), edit() or remove(), with the position of the entry
+     * and the new generation, so that the structures computed from the data
+     * can be updated instead of being rebuilt.
+     */
+    data_handler(const char* module, const char* path, void (*on_load)() = nullptr, reference_checker check_references = nullptr, change_listener on_change = nullptr)
+            : module(module), path(path), on_load(on_load), check_references(check_references), on_change(on_change) {
+        register_module_endpoint(module, this);
     };
 
     //data_handler should never be copied
@@ -33,11 +73,75 @@ struct data_handler {
         return changed;
     }
 
+    bool is_loaded() const {
+        return loaded;
+    }
+
+    /*!
+     * \brief Load the data if this has not been done yet.
+     */
+    void ensure_loaded() {
+        if (!loaded) {
+            load();
+        }
+    }
+
+    /*!
+     * \brief Returns a counter that is incremented each time the data
+     * is modified. This can be used to invalidate structures computed from
+     * the data.
+     */
+    size_t generation() const {
+        return current_generation;
+    }
+
+    /*!
+     * \brief Indicates that the data has been modified from outside the
+     * handler. The entries may have been renumbered or reordered, so the
+     * index is rebuilt right away, while the writer still holds the lock.
+     */
     void set_changed() {
-        if (is_server_running()) {
-            force_save();
+        reindex();
+        ++current_generation;
+
+        // The modified entries are not known, the clients need to fetch everything
+        sync_full_generation = current_generation;
+        sync_changes.clear();
+
+        mark_changed();
+    }
+
+    void write_changes(std::ostream& stream, const std::string& since) override {
+        auto parts = split(since, ':');
+
+        size_t version = 0;
+        bool delta     = false;
+
+        if (parts.size() == 2 && parts[0] == server_epoch()) {
+            version = to_number<size_t>(parts[1]);
+            delta   = version >= sync_full_generation && version <= current_generation;
+        }
+
+        if (delta) {
+            stream << "delta:" << server_epoch() << ':' << current_generation << '\n';
+
+            for (auto& change : sync_changes) {
+                if (change.second > version) {
+                    auto slot = find(change.first);
+
+                    if (slot == data.size()) {
+                        stream << "-:" << change.first << '\n';
+                    } else {
+                        stream << "+:" << data[slot] << '\n';
+                    }
+                }
+            }
         } else {
-            changed = true;
+            stream << "full:" << server_epoch() << ':' << current_generation << '\n';
+
+            for (auto& entry : data) {
+                stream << entry << '\n';
+            }
         }
     }
 
@@ -46,12 +150,14 @@ struct data_handler {
         next_id = 1;
 
         std::string line;
+        std::vector<std::string> parts;
+
         while (file.good() && getline(file, line)) {
             if (line.empty()) {
                 continue;
             }
 
-            auto parts = split(line, ':');
+            tokenize(line, ':', parts);
 
             T entry;
 
@@ -63,6 +169,8 @@ struct data_handler {
 
             data.push_back(std::move(entry));
         }
+
+        reindex();
     }
 
     template<typename Functor>
@@ -70,20 +178,27 @@ struct data_handler {
         //Make sure to clear the data first, as load_data can be called
         //several times
         data.clear();
+        loaded = true;
+        index.clear();
+        ++current_generation;
 
-        if(is_server_mode()){
-            auto res = budget::api_get(std::string("/") + module + "/list/");
+        sync_full_generation = current_generation;
+        sync_changes.clear();
 
-            if(res.success){
-                std::stringstream ss(res.result);
-                parse_stream(ss, f);
-            }
+        if(is_server_mode()){
+            load_from_server(f);
         } else {
             auto file_path = path_to_budget_file(path);
 
-            if (!file_exists(file_path)) {
-                next_id = 1;
-            } else {
+            next_id = 1;
+
+            bool binary = false;
+
+            if (columnar_traits<T>::enabled && (is_binary_storage() || !file_exists(file_path))) {
+                binary = load_columnar(path_to_budget_file(std::string(path) + ".bin"), columnar_tag());
+            }
+
+            if (!binary && file_exists(file_path)) {
                 std::ifstream file(file_path);
 
                 if (file.is_open()) {
@@ -98,6 +213,28 @@ struct data_handler {
                     }
                 }
             }
+
+            // Make sure the data is saved in the configured format
+            if (columnar_traits<T>::enabled && binary != is_binary_storage() && !data.empty()) {
+                changed = true;
+            }
+
+            // Replay the changes that have not been compacted yet
+            auto journal_path = path_to_budget_file(std::string(path) + ".journal");
+
+            journal_entries = 0;
+
+            if (file_exists(journal_path)) {
+                std::ifstream journal(journal_path);
+
+                if (journal.is_open()) {
+                    replay_journal(journal, f);
+                }
+            }
+        }
+
+        if (on_load) {
+            run_after_loading(on_load);
         }
     }
 
@@ -114,14 +251,36 @@ struct data_handler {
         }
 
         auto file_path = path_to_budget_file(path);
+        auto binary_path = path_to_budget_file(std::string(path) + ".bin");
 
-        std::ofstream file(file_path);
+        if (columnar_traits<T>::enabled && is_binary_storage()) {
+            if (!save_columnar(binary_path, columnar_tag())) {
+                std::cerr << "budget: error: Impossible to save " << binary_path << std::endl;
+                return;
+            }
 
-        // We still save the file ID so that it's still compatible with older versions for now
-        file << next_id << std::endl;
+            std::remove(file_path.c_str());
+        } else {
+            std::ofstream file(file_path);
 
-        for (auto& entry : data) {
-            file << entry << std::endl;
+            // We still save the file ID so that it's still compatible with older versions for now
+            file << next_id << std::endl;
+
+            for (auto& entry : data) {
+                file << entry << std::endl;
+            }
+
+            file.close();
+
+            if (columnar_traits<T>::enabled) {
+                std::remove(binary_path.c_str());
+            }
+        }
+
+        // Everything is now in the data file, the journal can go
+        if (journal_entries) {
+            std::remove(path_to_budget_file(std::string(path) + ".journal").c_str());
+            journal_entries = 0;
         }
 
         changed = false;
@@ -143,7 +302,24 @@ struct data_handler {
     }
 
     bool edit(T& value){
+        ensure_loaded();
+
+        ++current_generation;
+
+        track_change(value.id);
+
+        auto slot = find(value.id);
+
+        if (slot != data.size()) {
+            notify_change(data_change::edited, slot);
+        }
+
         if(is_server_mode()){
+            if (batching) {
+                batch_records << "+:" << value << '\n';
+                return true;
+            }
+
             auto params = value.get_params();
 
             auto res = budget::api_post(std::string("/") + get_module() + "/edit/", params);
@@ -156,14 +332,30 @@ struct data_handler {
                 return true;
             }
         } else {
-            set_changed();
+            if (is_server_running()) {
+                journal_append('+', value);
+            } else {
+                changed = true;
+            }
 
             return true;
         }
     }
 
     size_t add(T&& entry) {
+        ensure_loaded();
+
+        ++current_generation;
+
         if (is_server_mode()) {
+            // The id is only known once the batch is committed
+            if (batching) {
+                entry.id = 0;
+                batch_records << "+:" << entry << '\n';
+                batch_added.push_back(std::move(entry));
+                return 0;
+            }
+
             auto params = entry.get_params();
 
             auto res = budget::api_post(std::string("/") + get_module() + "/add/", params);
@@ -175,25 +367,49 @@ struct data_handler {
             } else {
                 entry.id = budget::to_number<size_t>(res.result);
 
-                data.push_back(std::forward<T>(entry));
+                append(std::forward<T>(entry));
+
+                notify_change(data_change::added, data.size() - 1);
             }
         } else {
             entry.id = next_id++;
 
-            data.push_back(std::forward<T>(entry));
+            track_change(entry.id);
+
+            append(std::forward<T>(entry));
+
+            notify_change(data_change::added, data.size() - 1);
 
-            set_changed();
+            if (is_server_running()) {
+                journal_append('+', data.back());
+            } else {
+                changed = true;
+            }
         }
 
         return entry.id;
     }
 
     void remove(size_t id) {
-        data.erase(std::remove_if(data.begin(), data.end(),
-                                  [id](const T& entry) { return entry.id == id; }),
-                   data.end());
+        ensure_loaded();
+
+        ++current_generation;
+
+        track_change(id);
+
+        auto slot = find(id);
+
+        if (slot != data.size()) {
+            erase(id);
+            notify_change(data_change::erased, slot);
+        }
 
         if (is_server_mode()) {
+            if (batching) {
+                batch_records << "-:" << id << '\n';
+                return;
+            }
+
             std::map<std::string, std::string> params;
 
             params["input_id"] = budget::to_string(id);
@@ -204,28 +420,168 @@ struct data_handler {
                 std::cerr << "error: Failed to delete from " << get_module() << std::endl;
             }
         } else {
-            set_changed();
+            if (is_server_running()) {
+                journal_append('-', id);
+            } else {
+                changed = true;
+            }
         }
     }
 
-    bool exists(size_t id) {
-        for (auto& entry : data) {
-            if (entry.id == id) {
-                return true;
+    /*!
+     * \brief Start a batch of mutations.
+     *
+     * Until the batch is committed, the mutations are queued instead of
+     * being sent one by one to the server (in server mode) or written one
+     * by one to the journal (while the server is running). In server mode,
+     * the ids of the added entries are only known after the commit.
+     */
+    void begin_batch() {
+        batching = true;
+    }
+
+    /*!
+     * \brief Apply all the mutations queued since begin_batch() at once
+     * \return true if the mutations were applied, false otherwise
+     */
+    bool commit_batch() {
+        batching = false;
+
+        auto records = batch_records.str();
+        batch_records.str("");
+
+        if (records.empty()) {
+            return true;
+        }
+
+        if (is_server_mode()) {
+            auto res = budget::api_post(std::string("/") + get_module() + "/mutations/", records, "text/plain");
+
+            std::vector<T> added;
+            added.swap(batch_added);
+
+            if (!res.success || res.result.compare(0, 6, "Error:") == 0) {
+                std::cerr << "error: Failed to apply the changes to " << get_module() << std::endl;
+                return false;
             }
+
+            // The server answers with the id of each mutation, in order
+            std::stringstream records_stream(records);
+            std::stringstream ids(res.result);
+
+            std::string record;
+            std::string id;
+            size_t current = 0;
+
+            while (getline(records_stream, record) && getline(ids, id)) {
+                if (record.compare(0, 4, "+:0:") == 0 && current < added.size()) {
+                    added[current].id = to_number<size_t>(id);
+                    append(std::move(added[current++]));
+                }
+            }
+
+            return true;
         }
 
-        return false;
+        journal_write(records, batch_size);
+        batch_size = 0;
+
+        return true;
     }
 
-    T& operator[](size_t id) {
-        for (auto& value : data) {
-            if (value.id == id) {
-                return value;
+    bool apply_mutations(std::istream& records, std::ostream& result, std::string& error) override {
+        std::vector<std::pair<char, T>> mutations;
+        std::vector<size_t> removed;
+
+        std::string line;
+        std::vector<std::string> parts;
+
+        // Validate all the mutations before applying any of them
+        while (getline(records, line)) {
+            if (line.empty()) {
+                continue;
             }
+
+            if (line.size() < 3 || line[1] != ':' || (line[0] != '+' && line[0] != '-')) {
+                error = "Invalid mutation: " + line;
+                return false;
+            }
+
+            T entry;
+
+            if (line[0] == '-') {
+                entry.id = parse_integer<size_t>(line.data() + 2, line.data() + line.size());
+            } else {
+                tokenize(line, ':', parts);
+                parts.erase(parts.begin());
+
+                if (parts.size() < entry_fields()) {
+                    error = "Invalid mutation: " + line;
+                    return false;
+                }
+
+                parts >> entry;
+
+                if (check_references && !check_references(entry, error)) {
+                    return false;
+                }
+            }
+
+            // Edited and removed entries must exist
+            if (entry.id && (!exists(entry.id) || std::find(removed.begin(), removed.end(), entry.id) != removed.end())) {
+                error = "No entry with id " + budget::to_string(entry.id);
+                return false;
+            }
+
+            if (line[0] == '-') {
+                if (!entry.id) {
+                    error = "Invalid mutation: " + line;
+                    return false;
+                }
+
+                removed.push_back(entry.id);
+            }
+
+            mutations.emplace_back(line[0], std::move(entry));
         }
 
-        cpp_unreachable("The data must exists");
+        begin_batch();
+
+        for (auto& mutation : mutations) {
+            auto& entry = mutation.second;
+
+            if (mutation.first == '-') {
+                remove(entry.id);
+                result << entry.id << '\n';
+            } else if (entry.id) {
+                auto& current = data[find(entry.id)];
+                current       = std::move(entry);
+                edit(current);
+                result << current.id << '\n';
+            } else {
+                result << add(std::move(entry)) << '\n';
+            }
+        }
+
+        return commit_batch();
+    }
+
+    bool exists(size_t id) {
+        ensure_loaded();
+
+        return find(id) != data.size();
+    }
+
+    T& operator[](size_t id) {
+        ensure_loaded();
+
+        auto slot = find(id);
+
+        if (slot == data.size()) {
+            cpp_unreachable("The data must exists");
+        }
+
+        return data[slot];
     }
 
     size_t size() const {
@@ -233,6 +589,8 @@ struct data_handler {
     }
 
     decltype(auto) begin() {
+        ensure_loaded();
+
         return data.begin();
     }
 
@@ -241,6 +599,8 @@ struct data_handler {
     }
 
     decltype(auto) end() {
+        ensure_loaded();
+
         return data.end();
     }
 
@@ -255,7 +615,303 @@ struct data_handler {
 private:
     const char* module;
     const char* path;
+    void (*on_load)();
+    reference_checker check_references;
+    change_listener on_change;
     bool changed = false;
+    bool loaded  = false;
+
+    std::unordered_map<size_t, size_t> index; ///< Position of each entry in data, by id
+    std::atomic<bool> indexed{false};         ///< Indicates if index has been built
+    std::mutex index_lock;                    ///< Protects the first build of the index
+    size_t journal_entries = 0;               ///< Number of records in the journal
+    size_t current_generation = 0;            ///< Incremented on each modification
+
+    std::unordered_map<size_t, size_t> sync_changes; ///< Generation of the last change of each entry, by id
+    size_t sync_full_generation = 0;                 ///< Generation of the last untracked modification
+
+    bool batching = false;            ///< Indicates if the mutations are queued
+    std::stringstream batch_records;  ///< The queued mutations, in the journal format
+    size_t batch_size = 0;            ///< Number of queued records in the journal
+    std::vector<T> batch_added;       ///< The entries added in server mode, waiting for their id
+
+    using columnar_tag = std::integral_constant<bool, columnar_traits<T>::enabled>;
+
+    bool load_columnar(const std::string& file_path, std::true_type) {
+        if (!columnar_load(file_path, data, next_id)) {
+            return false;
+        }
+
+        if (budget::config_contains("random")) {
+            for (auto& entry : data) {
+                entry.amount = budget::random_money(columnar_traits<T>::random_min, columnar_traits<T>::random_max);
+            }
+        }
+
+        reindex();
+
+        return true;
+    }
+
+    bool load_columnar(const std::string&, std::false_type) {
+        return false;
+    }
+
+    bool save_columnar(const std::string& file_path, std::true_type) {
+        return columnar_save(file_path, data, next_id);
+    }
+
+    bool save_columnar(const std::string&, std::false_type) {
+        return false;
+    }
+
+    void mark_changed() {
+        if (is_server_running()) {
+            force_save();
+        } else {
+            changed = true;
+        }
+    }
+
+    void notify_change(data_change change, size_t position) {
+        if (on_change) {
+            on_change(data, current_generation, change, position);
+        }
+    }
+
+    void track_change(size_t id) {
+        // Only the server needs to send the changes to its clients
+        if (is_server_running()) {
+            sync_changes[id] = current_generation;
+        }
+    }
+
+    /*!
+     * \brief Load the data from the server.
+     *
+     * The data is kept in a local replica, tagged with the version of the
+     * server, so that only the changes since this version are fetched.
+     */
+    template<typename Functor>
+    void load_from_server(Functor f) {
+        auto replica_path = path_to_budget_file(std::string(path) + ".replica");
+
+        std::string since;
+
+        {
+            std::ifstream replica(replica_path);
+
+            if (replica.is_open() && getline(replica, since)) {
+                parse_stream(replica, f);
+            }
+        }
+
+        auto res = budget::api_get(std::string("/") + module + "/list/?since=" + since);
+
+        if (!res.success) {
+            data.clear();
+            index.clear();
+            return;
+        }
+
+        std::stringstream ss(res.result);
+
+        bool delta = res.result.compare(0, 6, "delta:") == 0;
+        bool full  = res.result.compare(0, 5, "full:") == 0;
+
+        // Older servers only send the complete list
+        if (!delta && !full) {
+            data.clear();
+            index.clear();
+            parse_stream(ss, f);
+            return;
+        }
+
+        std::string header;
+        getline(ss, header);
+
+        if (delta) {
+            replay_journal(ss, f);
+
+            // Nothing changed, the replica is up to date
+            if (!journal_entries && header.substr(6) == since) {
+                return;
+            }
+
+            journal_entries = 0;
+        } else {
+            data.clear();
+            index.clear();
+            parse_stream(ss, f);
+        }
+
+        std::ofstream replica(replica_path);
+
+        replica << header.substr(header.find(':') + 1) << '\n';
+
+        for (auto& entry : data) {
+            replica << entry << '\n';
+        }
+    }
+
+    void reindex() {
+        index.clear();
+        index.reserve(data.size());
+
+        for (size_t i = 0; i < data.size(); ++i) {
+            index[data[i].id] = i;
+        }
+
+        indexed.store(true, std::memory_order_release);
+    }
+
+    /*!
+     * \brief Replay the journal on top of the loaded data.
+     *
+     * Each record is either "+:<entry>" for a new or modified entry or
+     * "-:<id>" for a removed entry. Replaying is idempotent, so a journal
+     * that has already been compacted can safely be replayed again.
+     */
+    template<typename Functor>
+    void replay_journal(std::istream& file, Functor f) {
+        std::string line;
+        std::vector<std::string> parts;
+
+        while (file.good() && getline(file, line)) {
+            if (line.size() < 3 || line[1] != ':') {
+                continue;
+            }
+
+            if (line[0] == '-') {
+                erase(parse_integer<size_t>(line.data() + 2, line.data() + line.size()));
+            } else if (line[0] == '+') {
+                tokenize(line, ':', parts);
+                parts.erase(parts.begin());
+
+                T entry;
+
+                f(parts, entry);
+
+                if (entry.id >= next_id) {
+                    next_id = entry.id + 1;
+                }
+
+                auto slot = find(entry.id);
+
+                if (slot == data.size()) {
+                    append(std::move(entry));
+                } else {
+                    data[slot] = std::move(entry);
+                }
+            }
+
+            ++journal_entries;
+        }
+    }
+
+    /*!
+     * \brief Append a record to the journal of the module, compacting it
+     * into the data file once it grows too large.
+     */
+    template<typename Value>
+    void journal_append(char operation, const Value& value) {
+        if (budget::config_contains("random")) {
+            std::cerr << "budget: error: Saving is disabled in random mode" << std::endl;
+            return;
+        }
+
+        if (batching) {
+            batch_records << operation << ':' << value << '\n';
+            ++batch_size;
+            return;
+        }
+
+        std::stringstream record;
+        record << operation << ':' << value << '\n';
+
+        journal_write(record.str(), 1);
+    }
+
+    /*!
+     * \brief Write several records to the journal at once, compacting it
+     * into the data file once it grows too large.
+     */
+    void journal_write(const std::string& records, size_t count) {
+        if (journal_entries + count >= journal_compaction_threshold) {
+            force_save();
+            return;
+        }
+
+        std::ofstream journal(path_to_budget_file(std::string(path) + ".journal"), std::ios::app);
+
+        journal << records;
+        journal.flush();
+
+        journal_entries += count;
+    }
+
+    /*!
+     * \brief Returns the number of fields of a serialized entry, which
+     * operator>> expects
+     */
+    static size_t entry_fields() {
+        static const size_t fields = [](){
+            std::stringstream stream;
+            stream << T();
+            auto entry = stream.str();
+            return size_t(std::count(entry.begin(), entry.end(), ':')) + 1;
+        }();
+
+        return fields;
+    }
+
+    void erase(size_t id) {
+        auto slot = find(id);
+
+        if (slot != data.size()) {
+            data.erase(data.begin() + slot);
+            index.erase(id);
+
+            // Only the entries after the removed one have moved
+            for (size_t i = slot; i < data.size(); ++i) {
+                index[data[i].id] = i;
+            }
+        }
+    }
+
+    void append(T&& entry) {
+        auto id = entry.id;
+
+        data.push_back(std::forward<T>(entry));
+
+        if (indexed.load(std::memory_order_relaxed)) {
+            index[id] = data.size() - 1;
+        }
+    }
+
+    /*!
+     * \brief Returns the position of the entry with the given id, or
+     * data.size() if there is no such entry.
+     */
+    size_t find(size_t id) {
+        // The index is only modified by the writers, the readers rendering
+        // pages in parallel only need to lock if it has never been built
+        if (!indexed.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> l(index_lock);
+
+            if (!indexed.load(std::memory_order_relaxed)) {
+                reindex();
+            }
+        }
+
+        auto it = index.find(id);
+
+        if (it == index.end()) {
+            return data.size();
+        }
+
+        return it->second;
+    }
 };
 
 } //end of namespace budget
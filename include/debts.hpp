@@ -55,11 +55,13 @@ std::vector<debt>& all_debts();
 
 void set_debts_changed();
 void set_debts_next_id(size_t next_id);
+size_t debts_generation();
 
 void display_all_debts(budget::writer& w);
 void list_debts(budget::writer& w);
 
 void add_debt(debt&& debt);
+bool edit_debt(debt& debt);
 bool debt_exists(size_t id);
 void debt_delete(size_t id);
 debt& debt_get(size_t id);
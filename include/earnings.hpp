@@ -15,7 +15,8 @@
 #include "money.hpp"
 #include "date.hpp"
 #include "writer_fwd.hpp"
-#include "filter_iterator.hpp"
+#include "month_index.hpp"
+#include "columnar.hpp"
 
 namespace budget {
 
@@ -42,6 +43,15 @@ struct earning {
     std::map<std::string, std::string> get_params();
 };
 
+template<>
+struct columnar_traits<earning> {
+    static constexpr const bool enabled = true;
+
+    // Range of the amounts generated in random mode
+    static constexpr const size_t random_min = 10;
+    static constexpr const size_t random_max = 5000;
+};
+
 std::ostream& operator<<(std::ostream& stream, const earning& earning);
 void operator>>(const std::vector<std::string>& parts, earning& earning);
 
@@ -50,9 +60,11 @@ void save_earnings();
 
 std::vector<earning>& all_earnings();
 void add_earning(earning&& earning);
+bool edit_earning(earning& earning);
 
 void set_earnings_changed();
 void set_earnings_next_id(size_t next_id);
+size_t earnings_generation();
 
 bool earning_exists(size_t id);
 void earning_delete(size_t id);
@@ -65,22 +77,8 @@ void show_earnings(budget::writer& w);
 
 // Filter functions
 
-inline auto all_earnings_month(budget::year year, budget::month month) {
-    return make_filter_view(begin(all_earnings()), end(all_earnings()), [=](const earning& e) {
-        return e.date.year() == year && e.date.month() == month;
-    });
-}
-
-inline auto all_earnings_month(size_t account_id, budget::year year, budget::month month) {
-    return make_filter_view(begin(all_earnings()), end(all_earnings()), [=](const earning& e) {
-        return e.account == account_id && e.date.year() == year && e.date.month() == month;
-    });
-}
-
-inline auto all_earnings_between(budget::year year, budget::month sm, budget::month month) {
-    return make_filter_view(begin(all_earnings()), end(all_earnings()), [=](const earning& e) {
-        return e.date.year() == year && e.date.month() >= sm && e.date.month() <= month;
-    });
-}
+month_view<earning> all_earnings_month(budget::year year, budget::month month);
+month_view<earning> all_earnings_month(size_t account_id, budget::year year, budget::month month);
+month_view<earning> all_earnings_between(budget::year year, budget::month sm, budget::month month);
 
 } //end of namespace budget
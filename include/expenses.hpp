@@ -15,7 +15,8 @@
 #include "money.hpp"
 #include "date.hpp"
 #include "writer_fwd.hpp"
-#include "filter_iterator.hpp"
+#include "month_index.hpp"
+#include "columnar.hpp"
 
 namespace budget {
 
@@ -44,6 +45,15 @@ struct expense {
     std::map<std::string, std::string> get_params();
 };
 
+template<>
+struct columnar_traits<expense> {
+    static constexpr const bool enabled = true;
+
+    // Range of the amounts generated in random mode
+    static constexpr const size_t random_min = 10;
+    static constexpr const size_t random_max = 1500;
+};
+
 std::ostream& operator<<(std::ostream& stream, const expense& expense);
 void operator>>(const std::vector<std::string>& parts, expense& expense);
 
@@ -56,6 +66,9 @@ bool edit_expense(expense& expense);
 
 void set_expenses_changed();
 void set_expenses_next_id(size_t next_id);
+size_t expenses_generation();
+void begin_expenses_batch();
+bool commit_expenses_batch();
 
 bool expense_exists(size_t id);
 void expense_delete(size_t id);
@@ -69,22 +82,8 @@ void search_expenses(const std::string& search, budget::writer& w);
 
 // Filter functions
 
-inline auto all_expenses_month(budget::year year, budget::month month) {
-    return make_filter_view(begin(all_expenses()), end(all_expenses()), [=](const expense& e) {
-        return e.date.year() == year && e.date.month() == month;
-    });
-}
-
-inline auto all_expenses_month(size_t account_id, budget::year year, budget::month month) {
-    return make_filter_view(begin(all_expenses()), end(all_expenses()), [=](const expense& e) {
-        return e.account == account_id && e.date.year() == year && e.date.month() == month;
-    });
-}
-
-inline auto all_expenses_between(budget::year year, budget::month sm, budget::month month) {
-    return make_filter_view(begin(all_expenses()), end(all_expenses()), [=](const expense& e) {
-        return e.date.year() == year && e.date.month() >= sm && e.date.month() <= month;
-    });
-}
+month_view<expense> all_expenses_month(budget::year year, budget::month month);
+month_view<expense> all_expenses_month(size_t account_id, budget::year year, budget::month month);
+month_view<expense> all_expenses_between(budget::year year, budget::month sm, budget::month month);
 
 } //end of namespace budget
@@ -0,0 +1,33 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <vector>
+
+namespace budget {
+
+using loader_function = void (*)();
+
+/*!
+ * \brief Run the given load functions concurrently on a small pool of
+ * threads and wait for all of them to complete.
+ *
+ * The hooks registered with run_after_loading() during the load are only
+ * run once all the data is loaded, in the order of the load functions.
+ * If a load function throws, the first exception (in the same order) is
+ * rethrown once all the functions are done.
+ */
+void load_concurrently(const std::vector<loader_function>& loaders);
+
+/*!
+ * \brief Run the given hook after the data has been loaded. The hook is
+ * run directly, unless a concurrent load is in progress.
+ */
+void run_after_loading(loader_function hook);
+
+} //end of namespace budget
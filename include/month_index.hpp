@@ -0,0 +1,254 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+
+#include "date.hpp"
+
+namespace budget {
+
+/*!
+ * \brief Iterator over the entries of a vector, in the order given by a
+ * range of positions.
+ */
+template <typename T>
+struct month_iterator {
+    using position_iterator = std::vector<size_t>::const_iterator;
+
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = T;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = T*;
+    using reference         = T&;
+
+    month_iterator(std::vector<T>& data, position_iterator it) : data(&data), it(it) {}
+
+    month_iterator& operator++() {
+        ++it;
+        return *this;
+    }
+
+    bool operator==(const month_iterator& rhs) const {
+        return it == rhs.it;
+    }
+
+    bool operator!=(const month_iterator& rhs) const {
+        return it != rhs.it;
+    }
+
+    T& operator*() const {
+        return (*data)[*it];
+    }
+
+    T* operator->() const {
+        return &(*data)[*it];
+    }
+
+private:
+    std::vector<T>* data;
+    position_iterator it;
+};
+
+template <typename T>
+struct month_view {
+    using position_iterator = std::vector<size_t>::const_iterator;
+
+    month_view(std::vector<T>& data, position_iterator first, position_iterator last) : data(&data), first(first), last(last) {}
+
+    month_iterator<T> begin() const {
+        return {*data, first};
+    }
+
+    month_iterator<T> end() const {
+        return {*data, last};
+    }
+
+    size_t size() const {
+        return std::distance(first, last);
+    }
+
+private:
+    std::vector<T>* data;
+    position_iterator first;
+    position_iterator last;
+};
+
+/*!
+ * \brief Index of dated entries (expenses or earnings) by year, month and
+ * account.
+ *
+ * The index is a permutation of the positions of the entries sorted by
+ * (year, month, account), so that the entries of a given month, of a given
+ * account in a month or of a range of months of the same year are
+ * contiguous. The modifications of single entries are applied in place,
+ * the index is only rebuilt lazily when the generation of the data changes
+ * in any other way. Lookups are safe from several threads reading the data
+ * at the same time.
+ */
+template <typename T>
+struct month_index {
+    month_view<T> month(std::vector<T>& data, size_t generation, budget::year year, budget::month month) {
+        return range(data, generation, key(year, month, 0), key(year, month + 1, 0));
+    }
+
+    month_view<T> month(std::vector<T>& data, size_t generation, size_t account, budget::year year, budget::month month) {
+        return range(data, generation, key(year, month, account), key(year, month, account + 1));
+    }
+
+    month_view<T> between(std::vector<T>& data, size_t generation, budget::year year, budget::month sm, budget::month month) {
+        return range(data, generation, key(year, sm, 0), key(year, month + 1, 0));
+    }
+
+    /*!
+     * \brief Update the index after the entry at the given position has
+     * been appended to the data
+     */
+    void added(const std::vector<T>& data, size_t generation, size_t position) {
+        std::lock_guard<std::mutex> l(lock);
+
+        if (!follows(generation, positions.size() + 1 == data.size())) {
+            return;
+        }
+
+        insert(data, position);
+    }
+
+    /*!
+     * \brief Update the index after the entry at the given position has
+     * been modified in place
+     */
+    void edited(const std::vector<T>& data, size_t generation, size_t position) {
+        std::lock_guard<std::mutex> l(lock);
+
+        if (!follows(generation, positions.size() == data.size())) {
+            return;
+        }
+
+        remove(position);
+        insert(data, position);
+    }
+
+    /*!
+     * \brief Update the index after the entry at the given position has
+     * been erased from the data
+     */
+    void erased(const std::vector<T>& data, size_t generation, size_t position) {
+        std::lock_guard<std::mutex> l(lock);
+
+        if (!follows(generation, positions.size() == data.size() + 1)) {
+            return;
+        }
+
+        remove(position);
+
+        for (auto& p : positions) {
+            if (p > position) {
+                --p;
+            }
+        }
+    }
+
+private:
+    std::vector<size_t> positions;
+    std::vector<uint64_t> keys;
+    size_t generation = 0;
+    bool built = false;
+    std::mutex lock;
+
+    static uint64_t key(size_t year, size_t month, size_t account) {
+        return uint64_t(year) << 48 | uint64_t(month) << 40 | uint64_t(account);
+    }
+
+    month_view<T> range(std::vector<T>& data, size_t current, uint64_t low, uint64_t high) {
+        high = std::max(low, high);
+
+        // The index is only rebuilt after a modification, which cannot
+        // happen while the returned views are in use
+        std::lock_guard<std::mutex> l(lock);
+
+        if (!built || generation != current || positions.size() != data.size()) {
+            rebuild(data);
+            generation = current;
+        }
+
+        auto first = std::lower_bound(keys.begin(), keys.end(), low) - keys.begin();
+        auto last  = std::lower_bound(keys.begin(), keys.end(), high) - keys.begin();
+
+        return {data, positions.begin() + first, positions.begin() + last};
+    }
+
+    /*!
+     * \brief Indicates if a single modification leads from the indexed data
+     * to the given generation, in which case the index can be updated in
+     * place. Otherwise, the index will be rebuilt on the next lookup.
+     */
+    bool follows(size_t current, bool consistent) {
+        if (!built || generation + 1 != current || !consistent) {
+            built = false;
+            return false;
+        }
+
+        generation = current;
+
+        return true;
+    }
+
+    // The positions are sorted by key and then by position, as after the
+    // stable sort of rebuild()
+
+    void insert(const std::vector<T>& data, size_t position) {
+        auto k = key(data[position].date.year(), data[position].date.month(), data[position].account);
+
+        auto first = std::lower_bound(keys.begin(), keys.end(), k) - keys.begin();
+        auto last  = std::upper_bound(keys.begin(), keys.end(), k) - keys.begin();
+
+        auto at = std::upper_bound(positions.begin() + first, positions.begin() + last, position) - positions.begin();
+
+        keys.insert(keys.begin() + at, k);
+        positions.insert(positions.begin() + at, position);
+    }
+
+    void remove(size_t position) {
+        auto at = std::find(positions.begin(), positions.end(), position) - positions.begin();
+
+        keys.erase(keys.begin() + at);
+        positions.erase(positions.begin() + at);
+    }
+
+    void rebuild(const std::vector<T>& data) {
+        positions.resize(data.size());
+
+        for (size_t i = 0; i < data.size(); ++i) {
+            positions[i] = i;
+        }
+
+        auto entry_key = [&data](size_t i) {
+            return key(data[i].date.year(), data[i].date.month(), data[i].account);
+        };
+
+        std::stable_sort(positions.begin(), positions.end(), [&entry_key](size_t a, size_t b) {
+            return entry_key(a) < entry_key(b);
+        });
+
+        keys.resize(data.size());
+
+        for (size_t i = 0; i < positions.size(); ++i) {
+            keys[i] = entry_key(positions[i]);
+        }
+
+        built = true;
+    }
+};
+
+} //end of namespace budget
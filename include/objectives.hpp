@@ -44,6 +44,47 @@ struct objective {
     std::map<std::string, std::string> get_params();
 };
 
+enum class objective_period {
+    none,
+    monthly,
+    yearly
+};
+
+enum class objective_source {
+    balance,
+    earnings,
+    expenses,
+    savings_rate
+};
+
+enum class objective_op {
+    none,
+    min,
+    max
+};
+
+/*!
+ * \brief An objective compiled for evaluation, with its type, source and
+ * operator resolved once instead of at each evaluation.
+ */
+struct compiled_objective {
+    size_t id;
+    objective_period period;
+    objective_source source;
+    objective_op op;
+    int amount; ///< The amount of the objective, in dollars
+
+    /*!
+     * \brief Returns the value of the status compared to the amount
+     */
+    int basis(const budget::status& status) const;
+
+    /*!
+     * \brief Returns the success of the objective in the status, in percent
+     */
+    int success(const budget::status& status) const;
+};
+
 std::ostream& operator<<(std::ostream& stream, const objective& expense);
 void operator>>(const std::vector<std::string>& parts, objective& expense);
 
@@ -58,17 +99,39 @@ std::vector<objective>& all_objectives();
 
 void set_objectives_changed();
 void set_objectives_next_id(size_t next_id);
+size_t objectives_generation();
 
 int compute_success(const budget::status& status, const objective& objective);
 
+compiled_objective compile_objective(const objective& objective);
+
+/*!
+ * \brief Returns all the objectives, compiled. They are only compiled again
+ * after the objectives have been modified.
+ */
+std::vector<compiled_objective> compiled_objectives();
+
+/*!
+ * \brief Compute the success of the objective in each of the statuses
+ */
+std::vector<int> compute_successes(const compiled_objective& objective, const std::vector<budget::status>& statuses);
+
 void list_objectives(budget::writer& w);
 void status_objectives(budget::writer& w);
 
 void add_objective(objective&& objective);
+bool edit_objective(objective& objective);
 bool objective_exists(size_t id);
 void objective_delete(size_t id);
 objective& objective_get(size_t id);
 
+std::string get_status(const budget::status& status, const budget::compiled_objective& objective);
+std::string get_success(const budget::status& status, const budget::compiled_objective& objective);
+
+/*!
+ * \brief Compile the objective and returns its status. The compiled
+ * overloads should be preferred for the objectives of compiled_objectives().
+ */
 std::string get_status(const budget::status& status, const budget::objective& objective);
 std::string get_success(const budget::status& status, const budget::objective& objective);
 
@@ -0,0 +1,49 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cstddef>
+
+namespace budget {
+
+/*!
+ * \brief The number of months returned when the target is never reached
+ */
+constexpr size_t never_fi = std::numeric_limits<size_t>::max();
+
+/*!
+ * \brief A scenario of the evolution of the net worth, with the same savings
+ * added at the end of each month.
+ */
+struct fi_scenario {
+    double nw;      ///< The starting net worth
+    double target;  ///< The net worth to reach
+    double savings; ///< The savings added each month
+};
+
+/*!
+ * \brief Compute the number of months before the net worth of the scenario
+ * reaches its target, when it grows by monthly_return each month.
+ *
+ * The number of months is computed with the annuity formula and checked
+ * against the projected net worth, so it is the same as with a monthly
+ * loop, in constant time.
+ *
+ * \return The number of months, or never_fi if the target cannot be reached
+ */
+size_t months_to_fi(const fi_scenario& scenario, double monthly_return);
+
+/*!
+ * \brief Compute the number of months to FI of each of the scenarios, all
+ * growing by monthly_return each month.
+ */
+std::vector<size_t> months_to_fi(const std::vector<fi_scenario>& scenarios, double monthly_return);
+
+} //end of namespace budget
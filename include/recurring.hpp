@@ -21,7 +21,6 @@ namespace budget {
 struct recurring_module {
     void load();
     void unload();
-    void preload();
     void handle(const std::vector<std::string>& args);
 };
 
@@ -63,10 +62,12 @@ std::vector<recurring>& all_recurrings();
 
 void set_recurrings_changed();
 void set_recurrings_next_id(size_t next_id);
+size_t recurrings_generation();
 
 void show_recurrings(budget::writer& w);
 
 void add_recurring(recurring&& recurring);
+bool edit_recurring(recurring& recurring);
 bool recurring_exists(size_t id);
 void recurring_delete(size_t id);
 recurring& recurring_get(size_t id);
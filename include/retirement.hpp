@@ -28,6 +28,27 @@ struct module_traits<retirement_module> {
 };
 
 float fi_ratio(budget::date d);
+
+/*!
+ * \brief The FI ratio at the first net worth point of a month
+ */
+struct fi_ratio_point {
+    budget::date date;
+    float ratio;
+};
+
+/*!
+ * \brief Compute the FI ratio for each month of the net worth timeline, in
+ * a single pass over the timeline and the monthly expenses.
+ */
+std::vector<fi_ratio_point> fi_ratio_timeline();
+
 void retirement_status(budget::writer& w);
 
+/*!
+ * \brief Simulate the time to FI on many random paths of the returns and
+ * display its percentiles and the probability to reach FI.
+ */
+void retirement_simulation(budget::writer& w);
+
 } //end of namespace budget
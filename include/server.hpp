@@ -9,6 +9,9 @@
 
 #include <vector>
 #include <string>
+#include <mutex>
+#include <shared_mutex>
+#include <iosfwd>
 
 #include "module_traits.hpp"
 
@@ -28,4 +31,81 @@ struct module_traits<server_module> {
 void set_server_running();
 bool is_server_running();
 
+/*!
+ * \brief Returns an identifier of the running server instance. The
+ * versions of the data sent to the clients are only meaningful within the
+ * same instance.
+ */
+const std::string& server_epoch();
+
+/*!
+ * \brief The data of a module, as seen by the clients of the server
+ */
+struct module_endpoint {
+    /*!
+     * \brief Write the changes since the given version ("epoch:generation")
+     * to the stream. If they cannot be computed, all the data is written.
+     */
+    virtual void write_changes(std::ostream& stream, const std::string& since) = 0;
+
+    /*!
+     * \brief Apply a batch of mutations, in the journal format, at once.
+     *
+     * Either all the mutations are applied or none of them. The id of the
+     * entry of each mutation is written on its own line to the result.
+     *
+     * \return true if the mutations were applied, false otherwise
+     */
+    virtual bool apply_mutations(std::istream& records, std::ostream& result, std::string& error) = 0;
+};
+
+void register_module_endpoint(const std::string& module, module_endpoint* endpoint);
+
+/*!
+ * \brief Write the changes of the given module since the given version
+ * \return false if there is no such module
+ */
+bool write_sync_changes(const std::string& module, const std::string& since, std::ostream& stream);
+
+/*!
+ * \brief Apply a batch of mutations to the given module
+ * \return false if there is no such module or the mutations are invalid
+ */
+bool apply_mutations(const std::string& module, std::istream& records, std::ostream& result, std::string& error);
+
+/*
+ * The data of the modules is shared between the threads of the server.
+ * Pages and read-only API calls are served under a shared lock, so that
+ * any number of them can run in parallel, while the mutations (API calls
+ * and the cron jobs) are done under an exclusive lock.
+ */
+
+using data_read_lock  = std::shared_lock<std::shared_timed_mutex>;
+using data_write_lock = std::unique_lock<std::shared_timed_mutex>;
+
+data_read_lock read_data_lock();
+data_write_lock write_data_lock();
+
+/*!
+ * \brief Wrap a request handler so that it runs with the data locked for reading
+ */
+template<typename Handler>
+auto read_locked(Handler handler){
+    return [handler](const auto& req, auto& res){
+        auto lock = read_data_lock();
+        handler(req, res);
+    };
+}
+
+/*!
+ * \brief Wrap a request handler so that it runs with the data locked for writing
+ */
+template<typename Handler>
+auto write_locked(Handler handler){
+    return [handler](const auto& req, auto& res){
+        auto lock = write_data_lock();
+        handler(req, res);
+    };
+}
+
 } //end of namespace budget
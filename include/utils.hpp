@@ -15,15 +15,72 @@
 #include <cctype>
 #include <locale>
 #include <iomanip>
+#include <type_traits>
+#include <limits>
 
 namespace budget {
 
+/*!
+ * \brief Parse an integer from the given range of characters, without
+ * allocating. Leading whitespace and a sign are accepted and parsing stops
+ * at the first character that is not a digit. A number out of the range of
+ * the type is saturated to its limit, as with the streams.
+ */
+template <typename T>
+inline T parse_integer(const char* first, const char* last) {
+    while (first != last && std::isspace(static_cast<unsigned char>(*first))) {
+        ++first;
+    }
+
+    bool negative = false;
+
+    if (first != last && (*first == '-' || *first == '+')) {
+        negative = *first == '-';
+        ++first;
+    }
+
+    // The largest magnitude that fits in T, with the sign of the number
+    const unsigned long long limit = negative && std::is_signed<T>::value
+        ? static_cast<unsigned long long>(-(std::numeric_limits<T>::min() + 1)) + 1
+        : static_cast<unsigned long long>(std::numeric_limits<T>::max());
+
+    unsigned long long value = 0;
+
+    while (first != last && *first >= '0' && *first <= '9') {
+        unsigned digit = *first - '0';
+
+        if (value > (limit - digit) / 10) {
+            value = limit;
+            break;
+        }
+
+        value = value * 10 + digit;
+        ++first;
+    }
+
+    if (negative) {
+        value = 0 - value;
+    }
+
+    return static_cast<T>(value);
+}
+
 /*!
  * \brief Convert a string to a number of an arbitrary type.
  * \param text The string to convert.
  * \return The converted text in the good type.
  */
-template <typename T>
+template <typename T, std::enable_if_t<std::is_integral<T>::value, int> = 0>
+inline T to_number (const std::string& text) {
+    return parse_integer<T>(text.data(), text.data() + text.size());
+}
+
+/*!
+ * \brief Convert a string to a number of an arbitrary type.
+ * \param text The string to convert.
+ * \return The converted text in the good type.
+ */
+template <typename T, std::enable_if_t<!std::is_integral<T>::value, int> = 0>
 inline T to_number (const std::string& text) {
     std::stringstream ss(text);
     T result;
@@ -64,6 +121,13 @@ bool folder_exists(const std::string& name);
 std::vector<std::string> split(const std::string &s, char delim);
 std::vector<std::string> &split(const std::string &s, char delim, std::vector<std::string> &elems);
 
+/*!
+ * \brief Split the string into the given tokens, reusing the storage of
+ * the tokens from a previous call. When called in a loop over lines of a
+ * similar shape, this does not allocate after the first lines.
+ */
+void tokenize(const std::string& s, char delim, std::vector<std::string>& tokens);
+
 std::string base64_decode(const std::string& in);
 std::string base64_encode(const std::string& in);
 
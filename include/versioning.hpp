@@ -24,7 +24,6 @@ template<>
 struct module_traits<versioning_module> {
     static constexpr const bool is_default = false;
     static constexpr const char* command = "versioning";
-    static constexpr const bool disable_preloading = true;
 
     static constexpr const std::array<std::pair<const char*, const char*>, 1> aliases = {{{"sync", "versioning sync"}}};
 };
@@ -54,6 +54,7 @@ std::vector<wish>& all_wishes();
 
 void set_wishes_changed();
 void set_wishes_next_id(size_t next_id);
+size_t wishes_generation();
 
 void migrate_wishes_2_to_3();
 void migrate_wishes_3_to_4();
@@ -62,7 +63,15 @@ void list_wishes(budget::writer& w);
 void status_wishes(budget::writer& w);
 void estimate_wishes(budget::writer& w);
 
+/*!
+ * \brief Plan the purchase of all the wishes together, by order of
+ * importance and urgency, each wish being paid before the next ones are
+ * planned.
+ */
+void plan_wishes(budget::writer& w);
+
 void add_wish(wish&& wish);
+bool edit_wish(wish& wish);
 bool wish_exists(size_t id);
 void wish_delete(size_t id);
 wish& wish_get(size_t id);
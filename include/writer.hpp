@@ -52,6 +52,33 @@ struct add_button {
             : module(module) {}
 };
 
+/*!
+ * \brief The kind of a column of a streamed table
+ */
+enum class column_kind {
+    normal,  ///< A standard column
+    id,      ///< The identifier of the entry, hidden in the web interface
+    success, ///< A column of success cells
+    edit     ///< A column of edit cells, not displayed in the console
+};
+
+struct table_column {
+    std::string name;
+    column_kind kind;
+
+    table_column(const char* name, column_kind kind = column_kind::normal) : name(name), kind(kind) {}
+};
+
+/*!
+ * \brief The style of a cell of a streamed table
+ */
+enum class cell_style {
+    none,
+    red,
+    green,
+    blue
+};
+
 struct writer {
     virtual writer& operator<<(const std::string& value) = 0;
     virtual writer& operator<<(const double& value) = 0;
@@ -82,6 +109,24 @@ struct writer {
 
     virtual void display_table(std::vector<std::string>& columns, std::vector<std::vector<std::string>>& contents, size_t groups = 1, std::vector<size_t> lines = {}, size_t left = 0, size_t foot = 0) = 0;
     virtual void display_graph(const std::string& title, std::vector<std::string>& categories, std::vector<std::string> series_names, std::vector<std::vector<float>>& series_values) = 0;
+
+    // Streamed tables, written one row at a time:
+    // begin_table, then for each row begin_table_row, one cell per column
+    // and end_table_row, optionally begin_table_footer followed by more
+    // rows and finally end_table.
+
+    virtual void begin_table(std::vector<table_column> columns) = 0;
+    virtual void begin_table_row() = 0;
+    virtual void end_table_row() = 0;
+    virtual void begin_table_footer() = 0;
+    virtual void end_table() = 0;
+
+    virtual void table_cell(const std::string& value, cell_style style = cell_style::none) = 0;
+    virtual void table_cell(const budget::money& value, cell_style style = cell_style::none) = 0;
+    virtual void table_cell(const budget::date& value) = 0;
+    virtual void table_cell(size_t value) = 0;
+    virtual void table_success_cell(unsigned long success) = 0;
+    virtual void table_edit_cell(const std::string& module, size_t id) = 0;
 };
 
 struct console_writer : writer {
@@ -106,6 +151,29 @@ struct console_writer : writer {
 
     virtual void display_table(std::vector<std::string>& columns, std::vector<std::vector<std::string>>& contents, size_t groups = 1, std::vector<size_t> lines = {}, size_t left = 0, size_t foot = 0) override;
     virtual void display_graph(const std::string& title, std::vector<std::string>& categories, std::vector<std::string> series_names, std::vector<std::vector<float>>& series_values) override;
+
+    virtual void begin_table(std::vector<table_column> columns) override;
+    virtual void begin_table_row() override;
+    virtual void end_table_row() override;
+    virtual void begin_table_footer() override;
+    virtual void end_table() override;
+
+    virtual void table_cell(const std::string& value, cell_style style = cell_style::none) override;
+    virtual void table_cell(const budget::money& value, cell_style style = cell_style::none) override;
+    virtual void table_cell(const budget::date& value) override;
+    virtual void table_cell(size_t value) override;
+    virtual void table_success_cell(unsigned long success) override;
+    virtual void table_edit_cell(const std::string& module, size_t id) override;
+
+private:
+    // The console needs all the rows to align the columns
+    std::vector<table_column> table_columns;
+    std::vector<std::vector<std::string>> table_contents;
+    size_t current_column = 0;
+    size_t table_foot = 0;
+    bool table_in_foot = false;
+
+    bool next_table_cell();
 };
 
 struct html_writer : writer {
@@ -134,6 +202,19 @@ struct html_writer : writer {
     virtual void display_table(std::vector<std::string>& columns, std::vector<std::vector<std::string>>& contents, size_t groups = 1, std::vector<size_t> lines = {}, size_t left = 0, size_t foot = 0) override;
     virtual void display_graph(const std::string& title, std::vector<std::string>& categories, std::vector<std::string> series_names, std::vector<std::vector<float>>& series_values) override;
 
+    virtual void begin_table(std::vector<table_column> columns) override;
+    virtual void begin_table_row() override;
+    virtual void end_table_row() override;
+    virtual void begin_table_footer() override;
+    virtual void end_table() override;
+
+    virtual void table_cell(const std::string& value, cell_style style = cell_style::none) override;
+    virtual void table_cell(const budget::money& value, cell_style style = cell_style::none) override;
+    virtual void table_cell(const budget::date& value) override;
+    virtual void table_cell(size_t value) override;
+    virtual void table_success_cell(unsigned long success) override;
+    virtual void table_edit_cell(const std::string& module, size_t id) override;
+
     void defer_script(const std::string& script);
     void load_deferred_scripts();
 
@@ -144,7 +225,12 @@ private:
     std::vector<std::string> modules;
     bool title_started = false;
 
+    std::vector<table_column> table_columns;
+    size_t current_column = 0;
+    bool table_in_foot = false;
+
     bool need_module(const std::string& module);
+    bool next_table_cell();
 };
 
 } //end of namespace budget
@@ -9,6 +9,8 @@
 #include <fstream>
 #include <sstream>
 #include <unordered_map>
+#include <mutex>
+#include <algorithm>
 
 #include "accounts.hpp"
 #include "budget_exception.hpp"
@@ -21,6 +23,7 @@
 #include "earnings.hpp"
 #include "expenses.hpp"
 #include "writer.hpp"
+#include "loader.hpp"
 
 using namespace budget;
 
@@ -28,16 +31,125 @@ namespace {
 
 static data_handler<account> accounts { "accounts", "accounts.data" };
 
-size_t get_account_id(std::string name, budget::year year, budget::month month){
-    budget::date date(year, month, 5);
+/*!
+ * \brief Index of the accounts by validity and by name.
+ *
+ * An account is valid in a month if the 5th day of the month is strictly
+ * between its since and until dates, which makes a contiguous range of
+ * months. The months are split into segments in which the valid accounts do
+ * not change, so that the accounts of a month are found with a binary
+ * search and returned as a view, without any copy. The versions of each
+ * account are indexed by name. It is rebuilt lazily when the generation of
+ * the accounts changes and can be used from several threads reading the
+ * accounts at the same time.
+ */
+struct validity_index {
+    month_view<account> valid(std::vector<account>& data, size_t current, budget::year year, budget::month month) {
+        std::lock_guard<std::mutex> l(lock);
+
+        update(data, current);
+
+        auto m = month_index(year, month);
+        auto s = std::upper_bound(boundaries.begin(), boundaries.end(), m) - boundaries.begin();
+
+        // Before the first segment or after the last one, nothing is valid
+        if (s == 0 || size_t(s) == boundaries.size()) {
+            return {data, positions.end(), positions.end()};
+        }
 
-    for(auto& account : accounts.data){
-        if(account.since < date && account.until > date && account.name == name){
-            return account.id;
+        return {data, positions.begin() + offsets[s - 1], positions.begin() + offsets[s]};
+    }
+
+    account* find(std::vector<account>& data, size_t current, const std::string& name, budget::year year, budget::month month) {
+        std::lock_guard<std::mutex> l(lock);
+
+        update(data, current);
+
+        auto it = versions.find(name);
+
+        if (it != versions.end()) {
+            auto m = month_index(year, month);
+
+            for (auto i : it->second) {
+                if (first_months[i] <= m && m <= last_months[i]) {
+                    return &data[i];
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+private:
+    std::mutex lock;
+    bool built        = false;
+    size_t generation = 0;
+
+    std::vector<long> first_months;  ///< First valid month of each account
+    std::vector<long> last_months;   ///< Last valid month of each account
+    std::vector<long> boundaries;    ///< First month of each segment, plus the end of the last one
+    std::vector<size_t> offsets;     ///< Start of the valid accounts of each segment in positions
+    std::vector<size_t> positions;   ///< Positions of the valid accounts of each segment
+
+    std::unordered_map<std::string, std::vector<size_t>> versions;
+
+    static long month_index(budget::year year, budget::month month) {
+        return long(year) * 12 + long(month) - 1;
+    }
+
+    void update(const std::vector<account>& data, size_t current) {
+        if (built && generation == current && first_months.size() == data.size()) {
+            return;
+        }
+
+        first_months.resize(data.size());
+        last_months.resize(data.size());
+        boundaries.clear();
+        offsets.clear();
+        positions.clear();
+        versions.clear();
+
+        for (size_t i = 0; i < data.size(); ++i) {
+            auto& account = data[i];
+
+            first_months[i] = month_index(account.since.year(), account.since.month()) + (account.since.day() < 5 ? 0 : 1);
+            last_months[i]  = month_index(account.until.year(), account.until.month()) - (account.until.day() > 5 ? 0 : 1);
+
+            if (first_months[i] <= last_months[i]) {
+                boundaries.push_back(first_months[i]);
+                boundaries.push_back(last_months[i] + 1);
+            }
+
+            versions[account.name].push_back(i);
+        }
+
+        std::sort(boundaries.begin(), boundaries.end());
+        boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+        // The accounts are kept in the order of the data in each segment
+        for (size_t s = 0; s + 1 < boundaries.size(); ++s) {
+            offsets.push_back(positions.size());
+
+            for (size_t i = 0; i < data.size(); ++i) {
+                if (first_months[i] <= boundaries[s] && boundaries[s] <= last_months[i]) {
+                    positions.push_back(i);
+                }
+            }
         }
+
+        offsets.push_back(positions.size());
+
+        generation = current;
+        built      = true;
     }
+};
+
+static validity_index account_index;
 
-    return 0;
+size_t get_account_id(std::string name, budget::year year, budget::month month){
+    auto account = account_index.find(all_accounts(), accounts.generation(), name, year, month);
+
+    return account ? account->id : 0;
 }
 
 template<typename Values>
@@ -71,9 +183,7 @@ std::map<std::string, std::string> budget::account::get_params(){
 }
 
 void budget::accounts_module::load(){
-    load_accounts();
-    load_expenses();
-    load_earnings();
+    load_concurrently({load_accounts, load_expenses, load_earnings});
 }
 
 void budget::accounts_module::unload(){
@@ -388,7 +498,7 @@ void budget::accounts_module::handle(const std::vector<std::string>& args){
 }
 
 void budget::load_accounts(){
-    accounts.load();
+    accounts.ensure_loaded();
 }
 
 void budget::save_accounts(){
@@ -400,15 +510,13 @@ budget::account& budget::get_account(size_t id){
 }
 
 budget::account& budget::get_account(std::string name, budget::year year, budget::month month){
-    budget::date date(year, month, 5);
+    auto account = account_index.find(all_accounts(), accounts.generation(), name, year, month);
 
-    for(auto& account : accounts.data){
-        if(account.since < date && account.until > date && account.name == name){
-            return account;
-        }
+    if (!account) {
+        cpp_unreachable("The account does not exist");
     }
 
-    cpp_unreachable("The account does not exist");
+    return *account;
 }
 
 std::ostream& budget::operator<<(std::ostream& stream, const account& account){
@@ -432,6 +540,8 @@ void budget::operator>>(const std::vector<std::string>& parts, account& account)
 }
 
 bool budget::account_exists(const std::string& name){
+    accounts.ensure_loaded();
+
     for(auto& account : accounts.data){
         if(account.name == name){
             return true;
@@ -442,26 +552,18 @@ bool budget::account_exists(const std::string& name){
 }
 
 std::vector<account>& budget::all_accounts(){
+    accounts.ensure_loaded();
+
     return accounts.data;
 }
 
-std::vector<budget::account> budget::current_accounts(){
+month_view<account> budget::current_accounts(){
     auto today = budget::local_day();
     return all_accounts(today.year(), today.month());
 }
 
-std::vector<account> budget::all_accounts(budget::year year, budget::month month){
-    std::vector<account> accounts;
-
-    budget::date date(year, month, 5);
-
-    for(auto& account : all_accounts()){
-        if(account.since < date && account.until > date){
-            accounts.push_back(account);
-        }
-    }
-
-    return std::move(accounts);
+month_view<account> budget::all_accounts(budget::year year, budget::month month){
+    return account_index.valid(all_accounts(), accounts.generation(), year, month);
 }
 
 void budget::set_accounts_changed(){
@@ -472,6 +574,10 @@ void budget::set_accounts_next_id(size_t next_id){
     accounts.next_id = next_id;
 }
 
+size_t budget::accounts_generation(){
+    return accounts.generation();
+}
+
 std::vector<std::string> budget::all_account_names(){
     std::vector<std::string> account_names;
 
@@ -556,6 +662,10 @@ void budget::add_account(budget::account&& account){
     accounts.add(std::forward<budget::account>(account));
 }
 
+bool budget::edit_account(account& account){
+    return accounts.edit(account);
+}
+
 budget::date budget::find_new_since(){
     budget::date date(1400,1,1);
 
@@ -8,6 +8,9 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "cpp_utils/assert.hpp"
 
@@ -18,6 +21,67 @@
 
 namespace {
 
+/*!
+ * \brief Pool of clients to the server, shared by the whole process.
+ *
+ * The clients (and their SSL context) are created once and reused by all
+ * the requests. A client is only used by one request at a time, so that
+ * concurrent requests each get their own client. The connection itself is
+ * not reused: the client opens a new one for each request.
+ */
+struct client_pool {
+    std::unique_ptr<httplib::Client> acquire() {
+        {
+            std::lock_guard<std::mutex> l(lock);
+
+            if (!clients.empty()) {
+                auto client = std::move(clients.back());
+                clients.pop_back();
+                return client;
+            }
+        }
+
+        auto server      = budget::config_value("server_url");
+        auto server_port = budget::to_number<size_t>(budget::config_value("server_port"));
+
+        if (budget::is_server_ssl()) {
+            return std::make_unique<httplib::SSLClient>(server.c_str(), server_port);
+        } else {
+            return std::make_unique<httplib::Client>(server.c_str(), server_port);
+        }
+    }
+
+    void release(std::unique_ptr<httplib::Client> client) {
+        std::lock_guard<std::mutex> l(lock);
+
+        clients.push_back(std::move(client));
+    }
+
+private:
+    std::mutex lock;
+    std::vector<std::unique_ptr<httplib::Client>> clients;
+};
+
+client_pool pool;
+
+/*!
+ * \brief A client of the pool, given back to the pool at the end of the scope
+ */
+struct pooled_client {
+    pooled_client() : client(pool.acquire()) {}
+
+    ~pooled_client() {
+        pool.release(std::move(client));
+    }
+
+    httplib::Client& operator*() {
+        return *client;
+    }
+
+private:
+    std::unique_ptr<httplib::Client> client;
+};
+
 template<typename Cli>
 budget::api_response base_api_get(Cli& cli, const std::string& api, bool silent) {
     auto server      = budget::config_value("server_url");
@@ -73,27 +137,12 @@ budget::api_response base_api_get(Cli& cli, const std::string& api, bool silent)
 }
 
 template<typename Cli>
-budget::api_response base_api_post(Cli& cli, const std::string& api, const std::map<std::string, std::string>& params) {
+budget::api_response base_api_post(Cli& cli, const std::string& api, const std::string& content, const char* content_type) {
     auto server      = budget::config_value("server_url");
     auto server_port = budget::config_value("server_port");
 
     std::string api_complete = "/api" + api;
 
-    std::string query;
-    for (auto it = params.begin(); it != params.end(); ++it) {
-        if (it != params.begin()) {
-            query += "&";
-        }
-        query += it->first;
-        query += "=";
-        query += it->second;
-    }
-
-    // Add some form of identification
-    if (!params.empty()) {
-        query += "&budgetwarrior=666";
-    }
-
     httplib::Request req;
     req.method = "POST";
     req.path = api_complete.c_str();
@@ -110,8 +159,8 @@ budget::api_response base_api_post(Cli& cli, const std::string& api, const std::
         req.set_header("Authorization", ("Basic " + budget::base64_encode(user + ":" + password)).c_str());
     }
 
-    req.set_header("Content-Type", "application/x-www-form-urlencoded");
-    req.body = query;
+    req.set_header("Content-Type", content_type);
+    req.body = content;
 
     auto base_res = std::make_shared<httplib::Response>();
 
@@ -145,33 +194,34 @@ budget::api_response base_api_post(Cli& cli, const std::string& api, const std::
 budget::api_response budget::api_get(const std::string& api, bool silent) {
     cpp_assert(is_server_mode(), "api_get() should only be called in server mode");
 
-    auto server      = config_value("server_url");
-    auto server_port = config_value("server_port");
+    pooled_client cli;
 
-    if(is_server_ssl()){
-        httplib::SSLClient cli(server.c_str(), budget::to_number<size_t>(server_port));
+    return base_api_get(*cli, api, silent);
+}
 
-        return base_api_get(cli, api, silent);
-    } else {
-        httplib::Client cli(server.c_str(), budget::to_number<size_t>(server_port));
+budget::api_response budget::api_post(const std::string& api, const std::map<std::string, std::string>& params) {
+    std::string query;
+    for (auto it = params.begin(); it != params.end(); ++it) {
+        if (it != params.begin()) {
+            query += "&";
+        }
+        query += it->first;
+        query += "=";
+        query += it->second;
+    }
 
-        return base_api_get(cli, api, silent);
+    // Add some form of identification
+    if (!params.empty()) {
+        query += "&budgetwarrior=666";
     }
+
+    return api_post(api, query, "application/x-www-form-urlencoded");
 }
 
-budget::api_response budget::api_post(const std::string& api, const std::map<std::string, std::string>& params) {
+budget::api_response budget::api_post(const std::string& api, const std::string& content, const char* content_type) {
     cpp_assert(is_server_mode(), "api_post() should only be called in server mode");
 
-    auto server      = config_value("server_url");
-    auto server_port = config_value("server_port");
-
-    if(is_server_ssl()){
-        httplib::SSLClient cli(server.c_str(), budget::to_number<size_t>(server_port));
+    pooled_client cli;
 
-        return base_api_post(cli, api, params);
-    } else {
-        httplib::Client cli(server.c_str(), budget::to_number<size_t>(server_port));
-
-        return base_api_post(cli, api, params);
-    }
+    return base_api_post(*cli, api, content, content_type);
 }
@@ -10,6 +10,8 @@
 #include <sstream>
 #include <utility>
 #include <map>
+#include <unordered_map>
+#include <mutex>
 
 #include "assets.hpp"
 #include "budget_exception.hpp"
@@ -31,7 +33,80 @@ using namespace budget;
 namespace {
 
 static data_handler<asset> assets { "assets", "assets.data" };
-static data_handler<asset_value> asset_values { "asset_values", "asset_values.data" };
+
+/*!
+ * \brief Check that the asset of a value received in a batch exists
+ */
+bool check_asset(const budget::asset_value& asset_value, std::string& error){
+    if (!assets.exists(asset_value.asset_id)) {
+        error = "No asset with id " + budget::to_string(asset_value.asset_id);
+        return false;
+    }
+
+    return true;
+}
+
+static data_handler<asset_value> asset_values { "asset_values", "asset_values.data", nullptr, check_asset };
+
+/*!
+ * \brief Net worth after each date at which asset values were set.
+ *
+ * The timeline is computed with compute_asset_series(). It is recomputed
+ * when the assets, the asset values or the exchange rates have changed.
+ */
+struct timeline_cache {
+    std::shared_ptr<const std::vector<net_worth_point>> get(){
+        std::lock_guard<std::mutex> l(lock);
+
+        if (!valid || assets_generation != assets.generation() || values_generation != asset_values.generation()
+                || currency_generation != budget::currency_cache_generation()) {
+            // The previous snapshot may still be used by another thread
+            points = std::make_shared<const std::vector<net_worth_point>>(rebuild());
+
+            assets_generation   = assets.generation();
+            values_generation   = asset_values.generation();
+            currency_generation = budget::currency_cache_generation();
+            valid               = true;
+        }
+
+        return points;
+    }
+
+private:
+    std::mutex lock;
+    std::shared_ptr<const std::vector<net_worth_point>> points;
+
+    bool valid                  = false;
+    size_t assets_generation    = 0;
+    size_t values_generation    = 0;
+    size_t currency_generation  = 0;
+
+    std::vector<net_worth_point> rebuild(){
+        // The net worth, the portfolio and the cash
+        auto series = compute_asset_series(3, [](const asset& asset, size_t serie) {
+            if (serie == 1) {
+                return asset.portfolio ? 1.0f : 0.0f;
+            } else if (serie == 2) {
+                return asset.cash == budget::money(100) ? 1.0f : 0.0f;
+            }
+
+            return 1.0f;
+        });
+
+        std::vector<net_worth_point> points(series.dates.size());
+
+        for (size_t i = 0; i < points.size(); ++i) {
+            points[i].date      = series.dates[i];
+            points[i].net_worth = series.values[0][i];
+            points[i].portfolio = series.values[1][i];
+            points[i].cash      = series.values[2][i];
+        }
+
+        return points;
+    }
+};
+
+timeline_cache timeline;
 
 std::vector<std::string> get_asset_names(){
     std::vector<std::string> asset_names;
@@ -333,8 +408,8 @@ void budget::assets_module::handle(const std::vector<std::string>& args){
 }
 
 void budget::load_assets(){
-    assets.load();
-    asset_values.load();
+    assets.ensure_loaded();
+    asset_values.ensure_loaded();
 }
 
 void budget::save_assets(){
@@ -452,13 +527,91 @@ bool budget::asset_exists(const std::string& name){
 }
 
 std::vector<asset>& budget::all_assets(){
+    assets.ensure_loaded();
+
     return assets.data;
 }
 
 std::vector<asset_value>& budget::all_asset_values(){
+    asset_values.ensure_loaded();
+
     return asset_values.data;
 }
 
+budget::asset_series budget::compute_asset_series(size_t count, const asset_weight& weight){
+    asset_series series;
+    series.values.resize(count);
+
+    auto& values = all_asset_values();
+
+    std::vector<const asset_value*> sorted;
+    sorted.reserve(values.size());
+
+    for (auto& asset_value : values) {
+        sorted.push_back(&asset_value);
+    }
+
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const asset_value* a, const asset_value* b) { return a->set_date < b->set_date; });
+
+    struct asset_info {
+        double rate;
+        std::vector<float> weights;
+        std::vector<budget::money> current;
+    };
+
+    std::unordered_map<size_t, asset_info> infos;
+
+    auto default_currency = get_default_currency();
+
+    std::vector<budget::money> sums(count);
+
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        auto& asset_value = *sorted[i];
+
+        auto it = infos.find(asset_value.asset_id);
+
+        if (it == infos.end()) {
+            auto& asset = get_asset(asset_value.asset_id);
+
+            asset_info info;
+            info.rate = exchange_rate(asset.currency, default_currency);
+            info.current.resize(count);
+
+            for (size_t s = 0; s < count; ++s) {
+                info.weights.push_back(weight(asset, s));
+            }
+
+            it = infos.emplace(asset_value.asset_id, std::move(info)).first;
+        }
+
+        auto& info  = it->second;
+        auto amount = asset_value.amount * info.rate;
+
+        for (size_t s = 0; s < count; ++s) {
+            if (info.weights[s] == 0.0f) {
+                continue;
+            }
+
+            auto weighted = info.weights[s] == 1.0f ? amount : amount * info.weights[s];
+
+            sums[s] += weighted - info.current[s];
+            info.current[s] = weighted;
+        }
+
+        // Only keep a point once all the values of the date are set
+        if (i + 1 == sorted.size() || sorted[i + 1]->set_date != asset_value.set_date) {
+            series.dates.push_back(asset_value.set_date);
+
+            for (size_t s = 0; s < count; ++s) {
+                series.values[s].push_back(sums[s]);
+            }
+        }
+    }
+
+    return series;
+}
+
 std::vector<asset_value> budget::all_sorted_asset_values() {
     auto sorted_asset_values = all_asset_values();
 
@@ -480,10 +633,26 @@ void budget::set_assets_next_id(size_t next_id){
     assets.next_id = next_id;
 }
 
+size_t budget::assets_generation(){
+    return assets.generation();
+}
+
 void budget::set_asset_values_next_id(size_t next_id){
     asset_values.next_id = next_id;
 }
 
+size_t budget::asset_values_generation(){
+    return asset_values.generation();
+}
+
+void budget::begin_asset_values_batch(){
+    asset_values.begin_batch();
+}
+
+bool budget::commit_asset_values_batch(){
+    return asset_values.commit_batch();
+}
+
 std::string budget::get_default_currency(){
     if(budget::config_contains("default_currency")){
         return budget::config_value("default_currency");
@@ -922,6 +1091,10 @@ void budget::add_asset(budget::asset&& asset){
     assets.add(std::forward<budget::asset>(asset));
 }
 
+bool budget::edit_asset(asset& asset){
+    return assets.edit(asset);
+}
+
 bool budget::asset_value_exists(size_t id){
     return asset_values.exists(id);
 }
@@ -946,96 +1119,61 @@ void budget::add_asset_value(budget::asset_value&& asset_value){
     asset_values.add(std::forward<budget::asset_value>(asset_value));
 }
 
+bool budget::edit_asset_value(asset_value& asset_value){
+    return asset_values.edit(asset_value);
+}
+
 void budget::list_asset_values(budget::writer& w){
     if (!asset_values.data.size()) {
         w << "No asset values" << end_of_line;
         return;
     }
 
-    std::vector<std::string> columns = {"ID", "Asset", "Amount", "Date", "Edit"};
-    std::vector<std::vector<std::string>> contents;
+    w.begin_table({{"ID", column_kind::id}, "Asset", "Amount", "Date", {"Edit", column_kind::edit}});
 
     // Display the asset values
 
     for(auto& value : asset_values.data){
-        contents.push_back({to_string(value.id), get_asset(value.asset_id).name, to_string(value.amount), to_string(value.set_date), "::edit::asset_values::" + budget::to_string(value.id)});
+        w.begin_table_row();
+        w.table_cell(value.id);
+        w.table_cell(get_asset(value.asset_id).name);
+        w.table_cell(value.amount);
+        w.table_cell(value.set_date);
+        w.table_edit_cell("asset_values", value.id);
+        w.end_table_row();
     }
 
-    w.display_table(columns, contents);
+    w.end_table();
 }
 
 budget::money budget::get_portfolio_value(){
-    std::map<size_t, budget::money> asset_amounts;
-
-    for (auto& asset_value : all_sorted_asset_values()) {
-        auto& asset = get_asset(asset_value.asset_id);
-
-        if (asset.portfolio) {
-            asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(asset.currency, get_default_currency());
-        }
-    }
-
-    budget::money total;
-
-    for (auto& asset_amount : asset_amounts) {
-        total += asset_amount.second;
-    }
+    auto points = net_worth_timeline();
 
-    return total;
+    return points->empty() ? budget::money() : points->back().portfolio;
 }
 
 budget::money budget::get_net_worth(){
-    std::map<size_t, budget::money> asset_amounts;
-
-    for (auto& asset_value : all_sorted_asset_values()) {
-        auto& asset = get_asset(asset_value.asset_id);
-        asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(asset.currency, get_default_currency());
-    }
-
-    budget::money total;
-
-    for (auto& asset_amount : asset_amounts) {
-        total += asset_amount.second;
-    }
+    auto points = net_worth_timeline();
 
-    return total;
+    return points->empty() ? budget::money() : points->back().net_worth;
 }
 
 budget::money budget::get_net_worth(budget::date d){
-    std::map<size_t, budget::money> asset_amounts;
-
-    for (auto& asset_value : all_sorted_asset_values()) {
-        if (asset_value.set_date <= d) {
-            auto& asset = get_asset(asset_value.asset_id);
-            asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(asset.currency, get_default_currency());
-        }
-    }
-
-    budget::money total;
+    auto points = net_worth_timeline();
 
-    for (auto& asset_amount : asset_amounts) {
-        total += asset_amount.second;
-    }
+    // Find the last point set at or before d
+    auto it = std::upper_bound(points->begin(), points->end(), d,
+                               [](const budget::date& d, const net_worth_point& point) { return d < point.date; });
 
-    return total;
+    return it == points->begin() ? budget::money() : (it - 1)->net_worth;
 }
 
 budget::money budget::get_net_worth_cash(){
-    std::map<size_t, budget::money> asset_amounts;
-
-    for (auto& asset_value : all_sorted_asset_values()) {
-        auto& asset = get_asset(asset_value.asset_id);
-
-        if(asset.cash == budget::money(100)){
-            asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(asset.currency, get_default_currency());
-        }
-    }
-
-    budget::money total;
+    auto points = net_worth_timeline();
 
-    for (auto& asset_amount : asset_amounts) {
-        total += asset_amount.second;
-    }
+    return points->empty() ? budget::money() : points->back().cash;
+}
 
-    return total;
+std::shared_ptr<const std::vector<net_worth_point>> budget::net_worth_timeline(){
+    return timeline.get();
 }
@@ -70,7 +70,6 @@ struct Void {
 
 HAS_MEM_FUNC(load, has_load);
 HAS_MEM_FUNC(unload, has_unload);
-HAS_MEM_FUNC(preload, has_preload);
 
 template<typename Module>
 struct need_loading {
@@ -82,23 +81,6 @@ struct need_unloading {
     static const bool value = has_unload<Module, void(Module::*)()>::value;
 };
 
-template<typename Module>
-struct need_preloading {
-    static const bool value = has_preload<Module, void(Module::*)()>::value;
-};
-
-HAS_STATIC_FIELD(disable_preloading, has_disable_preloading_field)
-
-template<typename Module, typename Enable = void>
-struct disable_preloading {
-    static const bool value = false;
-};
-
-template<typename Module>
-struct disable_preloading<Module, std::enable_if_t<has_disable_preloading_field<module_traits<Module>>::value>> {
-    static const bool value = module_traits<Module>::disable_preloading;
-};
-
 HAS_STATIC_FIELD(aliases, has_aliases_field)
 
 template<typename Module, typename Enable = void>
@@ -111,24 +93,6 @@ struct has_aliases<Module, std::enable_if_t<has_aliases_field<module_traits<Modu
     static const bool value = true;
 };
 
-struct module_loader {
-    template<typename Module, cpp::enable_if_u<need_preloading<Module>::value> = cpp::detail::dummy>
-    inline void preload(){
-        Module module;
-        module.preload();
-    }
-
-    template<typename Module, cpp::disable_if_u<need_preloading<Module>::value> = cpp::detail::dummy>
-    inline void preload(){
-        //NOP
-    }
-
-    template<typename Module>
-    inline void operator()(){
-        preload<Module>();
-    }
-};
-
 struct module_runner {
     std::vector<std::string> args;
     bool handled = false;
@@ -159,12 +123,7 @@ struct module_runner {
 
     template<typename Module>
     inline void handle_module(){
-        //Preload each module that needs it
-        if(!disable_preloading<Module>::value){
-            module_loader loader;
-            cpp::for_each_tuple_t<modules_tuple>(loader);
-        }
-
+        //The data of the other modules is only loaded when accessed
         Module module;
 
         load(module);
@@ -0,0 +1,85 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "columnar.hpp"
+
+budget::mapped_file::mapped_file(const std::string& path){
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat sb;
+
+    if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        void* address = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (address != MAP_FAILED) {
+            content = static_cast<const char*>(address);
+            length  = sb.st_size;
+            mapped  = true;
+        }
+    }
+
+    close(fd);
+
+    if (mapped) {
+        return;
+    }
+#endif
+
+    // Fallback to reading the complete file in memory
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+    if (!file.is_open()) {
+        return;
+    }
+
+    auto size = file.tellg();
+
+    if (size <= 0) {
+        return;
+    }
+
+    auto buffer = new char[size];
+
+    file.seekg(0);
+
+    if (!file.read(buffer, size)) {
+        delete[] buffer;
+        return;
+    }
+
+    content = buffer;
+    length  = size;
+}
+
+budget::mapped_file::~mapped_file(){
+    if (!content) {
+        return;
+    }
+
+#ifndef _WIN32
+    if (mapped) {
+        munmap(const_cast<char*>(content), length);
+        return;
+    }
+#endif
+
+    delete[] content;
+}
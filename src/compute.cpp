@@ -6,12 +6,168 @@
 //=======================================================================
 
 #include <utility>
+#include <unordered_map>
+#include <mutex>
+#include <vector>
+#include <algorithm>
 
 #include "compute.hpp"
 #include "expenses.hpp"
 #include "earnings.hpp"
 #include "accounts.hpp"
 
+namespace {
+
+/*!
+ * \brief Totals of expenses, earnings and budget for each month.
+ *
+ * The expenses and earnings totals are computed in a single pass over
+ * the data and the budget of a month is computed the first time it is
+ * needed. Everything is recomputed after the corresponding module has
+ * been modified. The aggregates can be queried from several threads.
+ */
+struct monthly_aggregates {
+    budget::money expenses(budget::year year, budget::month month) {
+        std::lock_guard<std::mutex> l(lock);
+
+        update();
+
+        return find_total(expenses_totals, year, month);
+    }
+
+    budget::money earnings(budget::year year, budget::month month) {
+        std::lock_guard<std::mutex> l(lock);
+
+        update();
+
+        return find_total(earnings_totals, year, month);
+    }
+
+    budget::money budget(budget::year year, budget::month month) {
+        std::lock_guard<std::mutex> l(lock);
+
+        if (!budgets_valid || accounts_generation != budget::accounts_generation()) {
+            budgets.clear();
+
+            accounts_generation = budget::accounts_generation();
+            budgets_valid       = true;
+        }
+
+        auto k  = key(year, month);
+        auto it = budgets.find(k);
+
+        if (it == budgets.end()) {
+            it = budgets.emplace(k, accumulate_amount(budget::all_accounts(year, month))).first;
+        }
+
+        return it->second;
+    }
+
+    std::vector<budget::status> statuses(budget::date from, budget::date to) {
+        std::lock_guard<std::mutex> l(lock);
+
+        update();
+
+        std::vector<budget::status> result;
+
+        auto first = month_index(from.year(), from.month());
+        auto last  = month_index(to.year(), to.month());
+
+        if (last < first) {
+            return result;
+        }
+
+        result.resize(last - first + 1);
+
+        // An account is part of the budget of each month whose 5th day is
+        // inside its validity, which is a contiguous range of months. The
+        // budgets are accumulated from the changes at the ends of the ranges.
+        std::vector<budget::money> changes(result.size() + 1);
+
+        for (auto& account : budget::all_accounts()) {
+            auto since = month_index(account.since.year(), account.since.month()) + (account.since.day() < 5 ? 0 : 1);
+            auto until = month_index(account.until.year(), account.until.month()) - (account.until.day() > 5 ? 0 : 1);
+
+            since = std::max(since, first);
+            until = std::min(until, last);
+
+            if (since <= until) {
+                changes[since - first] += account.amount;
+                changes[until - first + 1] -= account.amount;
+            }
+        }
+
+        budget::money current_budget;
+
+        for (size_t i = 0; i < result.size(); ++i) {
+            auto year  = budget::year((first + i) / 12);
+            auto month = budget::month((first + i) % 12 + 1);
+
+            auto& status = result[i];
+
+            current_budget += changes[i];
+
+            status.expenses = find_total(expenses_totals, year, month);
+            status.earnings = find_total(earnings_totals, year, month);
+            status.budget   = current_budget;
+            status.balance  = status.budget + status.earnings - status.expenses;
+        }
+
+        return result;
+    }
+
+private:
+    std::mutex lock;
+
+    std::unordered_map<size_t, budget::money> expenses_totals;
+    std::unordered_map<size_t, budget::money> earnings_totals;
+    std::unordered_map<size_t, budget::money> budgets;
+
+    bool totals_valid           = false;
+    bool budgets_valid          = false;
+    size_t expenses_generation  = 0;
+    size_t earnings_generation  = 0;
+    size_t accounts_generation  = 0;
+
+    static size_t key(budget::year year, budget::month month) {
+        return size_t(year) * 16 + size_t(month);
+    }
+
+    static long month_index(budget::year year, budget::month month) {
+        return long(year) * 12 + long(month) - 1;
+    }
+
+    static budget::money find_total(const std::unordered_map<size_t, budget::money>& totals, budget::year year, budget::month month) {
+        auto it = totals.find(key(year, month));
+        return it == totals.end() ? budget::money() : it->second;
+    }
+
+    void update() {
+        if (totals_valid && expenses_generation == budget::expenses_generation() && earnings_generation == budget::earnings_generation()) {
+            return;
+        }
+
+        expenses_totals.clear();
+        earnings_totals.clear();
+
+        for (auto& expense : budget::all_expenses()) {
+            expenses_totals[key(expense.date.year(), expense.date.month())] += expense.amount;
+        }
+
+        for (auto& earning : budget::all_earnings()) {
+            earnings_totals[key(earning.date.year(), earning.date.month())] += earning.amount;
+        }
+
+        expenses_generation = budget::expenses_generation();
+        earnings_generation = budget::earnings_generation();
+        totals_valid        = true;
+    }
+};
+
+monthly_aggregates aggregates;
+
+} //end of anonymous namespace
+
 budget::status budget::compute_year_status() {
     auto today = budget::local_day();
     return compute_year_status(today.year(), today.month());
@@ -26,11 +182,10 @@ budget::status budget::compute_year_status(year year, month month) {
 
     auto sm = start_month(year);
 
-    status.expenses = accumulate_amount(all_expenses_between(year, sm, month));
-    status.earnings = accumulate_amount(all_earnings_between(year, sm, month));
-
     for (unsigned short i = sm; i <= month; ++i) {
-        status.budget += accumulate_amount(all_accounts(year, i));
+        status.expenses += aggregates.expenses(year, i);
+        status.earnings += aggregates.earnings(year, i);
+        status.budget += aggregates.budget(year, i);
     }
 
     status.balance = status.budget + status.earnings - status.expenses;
@@ -51,14 +206,18 @@ budget::status budget::compute_month_status(month month) {
 budget::status budget::compute_month_status(year year, month month) {
     budget::status status;
 
-    status.expenses = accumulate_amount(all_expenses_month(year, month));
-    status.earnings = accumulate_amount(all_earnings_month(year, month));
-    status.budget   = accumulate_amount(all_accounts(year, month));
+    status.expenses = aggregates.expenses(year, month);
+    status.earnings = aggregates.earnings(year, month);
+    status.budget   = aggregates.budget(year, month);
     status.balance  = status.budget + status.earnings - status.expenses;
 
     return status;
 }
 
+std::vector<budget::status> budget::compute_monthly_statuses(budget::date from, budget::date to) {
+    return aggregates.statuses(from, to);
+}
+
 budget::status budget::compute_avg_month_status() {
     auto today = budget::local_day();
     return compute_avg_month_status(today.year(), today.month());
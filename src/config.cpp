@@ -259,6 +259,10 @@ bool budget::is_fortune_disabled(){
     return config_contains("disable_fortune") && config_value("disable_fortune") == "true";
 }
 
+bool budget::is_binary_storage(){
+    return config_contains_and_true("binary_storage");
+}
+
 bool budget::net_worth_over_fortune(){
     // If the fortune module is disabled, use net worth
     if (config_contains("disable_fortune")) {
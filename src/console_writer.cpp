@@ -322,6 +322,113 @@ bool budget::console_writer::is_web() {
     return false;
 }
 
+void budget::console_writer::begin_table(std::vector<table_column> columns){
+    table_columns = std::move(columns);
+    table_contents.clear();
+    table_foot    = 0;
+    table_in_foot = false;
+}
+
+void budget::console_writer::begin_table_row(){
+    current_column = 0;
+
+    table_contents.emplace_back();
+    table_contents.back().reserve(table_columns.size());
+
+    if (table_in_foot) {
+        ++table_foot;
+    }
+}
+
+void budget::console_writer::end_table_row(){
+    // Nothing to do
+}
+
+void budget::console_writer::begin_table_footer(){
+    table_in_foot = true;
+}
+
+void budget::console_writer::end_table(){
+    std::vector<std::string> columns;
+
+    for (auto& column : table_columns) {
+        if (column.kind != column_kind::edit) {
+            columns.push_back(column.name);
+        }
+    }
+
+    if (!table_contents.empty() || !columns.empty()) {
+        display_table(columns, table_contents, 1, {}, 0, table_foot);
+    }
+
+    table_columns.clear();
+    table_contents.clear();
+}
+
+bool budget::console_writer::next_table_cell(){
+    cpp_assert(current_column < table_columns.size(), "Too many cells in the row");
+
+    // The edit columns are not displayed in the console
+    return table_columns[current_column++].kind != column_kind::edit;
+}
+
+void budget::console_writer::table_cell(const std::string& value, cell_style style){
+    if (!next_table_cell()) {
+        return;
+    }
+
+    switch (style) {
+        case cell_style::red:
+            table_contents.back().push_back("::red" + value);
+            break;
+        case cell_style::green:
+            table_contents.back().push_back("::green" + value);
+            break;
+        case cell_style::blue:
+            table_contents.back().push_back("::blue" + value);
+            break;
+        default:
+            table_contents.back().push_back(value);
+            break;
+    }
+}
+
+void budget::console_writer::table_cell(const budget::money& value, cell_style style){
+    table_cell(budget::to_string(value), style);
+}
+
+void budget::console_writer::table_cell(const budget::date& value){
+    if (!next_table_cell()) {
+        return;
+    }
+
+    table_contents.back().push_back(budget::to_string(value));
+}
+
+void budget::console_writer::table_cell(size_t value){
+    if (!next_table_cell()) {
+        return;
+    }
+
+    table_contents.back().push_back(budget::to_string(value));
+}
+
+void budget::console_writer::table_success_cell(unsigned long success){
+    if (!next_table_cell()) {
+        return;
+    }
+
+    table_contents.back().push_back("::success" + budget::to_string(success));
+}
+
+void budget::console_writer::table_edit_cell(const std::string& module, size_t id){
+    // The edit buttons are only available in the web interface
+    cpp_unused(module);
+    cpp_unused(id);
+
+    next_table_cell();
+}
+
 void budget::console_writer::display_graph(const std::string& title, std::vector<std::string>& categories, std::vector<std::string> series_names, std::vector<std::vector<float>>& series_values) {
     cpp_unused(title);
     cpp_unused(categories);
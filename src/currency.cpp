@@ -6,21 +6,257 @@
 //=======================================================================
 
 #include <map>
+#include <set>
 #include <utility>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <thread>
+#include <chrono>
 
 #include "currency.hpp"
 #include "assets.hpp"
+#include "config.hpp"
+#include "server.hpp"
+#include "utils.hpp"
 #include "http.hpp"
 
 namespace {
 
-std::map<std::pair<std::string, std::string>, double> exchanges;
+using currency_pair = std::pair<std::string, std::string>;
+
+// All the following variables are protected by the lock
+std::mutex lock;
+std::map<currency_pair, double> exchanges;
+std::set<currency_pair> pending;
+std::set<currency_pair> failed; // Rates that could not be fetched, never saved
+bool cache_loaded = false;
+bool fetching     = false;
+size_t generation = 0;
+budget::currency_cache_stats stats;
+
+std::string cache_path(){
+    return budget::path_to_budget_file("exchanges.cache");
+}
+
+void load_cache(){
+    if (cache_loaded) {
+        return;
+    }
+
+    cache_loaded = true;
+
+    std::ifstream file(cache_path());
+
+    if (!file.is_open()) {
+        return;
+    }
+
+    std::string line;
+    while (file.good() && getline(file, line)) {
+        auto parts = budget::split(line, ':');
+
+        if (parts.size() != 3) {
+            continue;
+        }
+
+        std::stringstream ss(parts[2]);
+        ss.imbue(std::locale::classic());
+
+        double rate = 1.0;
+        ss >> rate;
+
+        exchanges[std::make_pair(parts[0], parts[1])] = rate;
+    }
+}
+
+void save_cache(){
+    std::ofstream file(cache_path());
+    file.imbue(std::locale::classic());
+
+    for (auto& exchange : exchanges) {
+        file << exchange.first.first << ':' << exchange.first.second << ':' << exchange.second << std::endl;
+    }
+}
+
+bool http_exchange_rate(const std::string& from, const std::string& to, double& rate){
+    httplib::Client cli("free.currencyconverterapi.com", 80);
+
+    std::string api_complete = "/api/v3/convert?q=" + from + "_" + to + "&compact=ultra";
+
+    auto res = cli.get(api_complete.c_str());
+
+    if (!res) {
+        std::cout << "Error accessing exchange rates (no response), setting exchange between " << from << " to " << to << " to 1/1" << std::endl;
+
+        return false;
+    } else if (res->status != 200) {
+        std::cout << "Error accessing exchange rates (not OK), setting exchange between " << from << " to " << to << " to 1/1" << std::endl;
+
+        return false;
+    } else {
+        auto& buffer = res->body;
+
+        if (buffer.find(':') == std::string::npos || buffer.find('}') == std::string::npos) {
+            std::cout << "Error parsing exchange rates, setting exchange between " << from << " to " << to << " to 1/1" << std::endl;
+
+            return false;
+        } else {
+            std::string ratio_result(buffer.begin() + buffer.find(':') + 1, buffer.begin() + buffer.find('}'));
+
+            rate = atof(ratio_result.c_str());
+
+            return true;
+        }
+    }
+}
+
+/*!
+ * \brief Read the exchange rates from a local file, with one FROM:TO:RATE
+ * line per rate. This is used when exchange_rates_file is set in the
+ * configuration, for offline usage or testing.
+ */
+bool file_exchange_rate(const std::string& from, const std::string& to, double& rate){
+    std::ifstream file(budget::config_value("exchange_rates_file"));
+
+    std::string line;
+    while (file.good() && getline(file, line)) {
+        auto parts = budget::split(line, ':');
+
+        if (parts.size() == 3 && parts[0] == from && parts[1] == to) {
+            std::stringstream ss(parts[2]);
+            ss.imbue(std::locale::classic());
+            ss >> rate;
+
+            return true;
+        }
+    }
+
+    std::cout << "No exchange rate between " << from << " and " << to << " in the rates file, setting it to 1/1" << std::endl;
+
+    return false;
+}
+
+/*!
+ * \brief Fetch the exchange rate from the rates file or the online service,
+ * without holding the lock
+ * \return true if the rate was fetched, false otherwise
+ */
+bool fetch_exchange_rate(const std::string& from, const std::string& to, double& rate){
+    if (budget::config_contains("exchange_rates_file")) {
+        return file_exchange_rate(from, to, rate);
+    } else {
+        return http_exchange_rate(from, to, rate);
+    }
+}
+
+// Must be called with the lock held
+void store_exchange_rate(const currency_pair& key, double rate){
+    exchanges[key]                                    = rate;
+    exchanges[std::make_pair(key.second, key.first)] = 1.0 / rate;
+}
+
+/*!
+ * \brief Fetch all the pending exchange rates, in the background
+ */
+void fetch_pending(){
+    while (true) {
+        currency_pair key;
+
+        {
+            std::lock_guard<std::mutex> l(lock);
+
+            if (pending.empty()) {
+                fetching = false;
+                save_cache();
+                return;
+            }
+
+            key = *pending.begin();
+            pending.erase(pending.begin());
+        }
+
+        double rate = 1.0;
+        bool fetched = fetch_exchange_rate(key.first, key.second, rate);
+
+        std::lock_guard<std::mutex> l(lock);
+
+        // A rate that cannot be fetched stays at 1.0 but is not cached
+        if (fetched) {
+            store_exchange_rate(key, rate);
+            failed.erase(key);
+            ++generation;
+        } else {
+            failed.insert(key);
+        }
+    }
+}
 
 } // end of anonymous namespace
 
-void budget::invalidate_currency_cache(){
-    exchanges.clear();
+void budget::refresh_currency_cache(){
+    std::vector<currency_pair> keys;
+
+    {
+        std::lock_guard<std::mutex> l(lock);
+
+        load_cache();
+
+        // The reverse rates are computed from the direct ones
+        for (auto& exchange : exchanges) {
+            if (exchange.first.first < exchange.first.second) {
+                keys.push_back(exchange.first);
+            }
+        }
+
+        // The rates that could not be fetched are tried again
+        for (auto& key : failed) {
+            keys.push_back(key);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<double> rates(keys.size(), 1.0);
+    std::vector<char> fetched(keys.size(), false);
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        fetched[i] = fetch_exchange_rate(keys[i].first, keys[i].second, rates[i]);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::lock_guard<std::mutex> l(lock);
+
+    // The last known rate is kept when a rate cannot be fetched
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (fetched[i]) {
+            store_exchange_rate(keys[i], rates[i]);
+            failed.erase(keys[i]);
+        }
+    }
+
+    ++generation;
+    ++stats.refreshes;
+
+    stats.last_refresh_ms = duration;
+    stats.total_refresh_ms += duration;
+
+    save_cache();
+}
+
+size_t budget::currency_cache_generation(){
+    std::lock_guard<std::mutex> l(lock);
+
+    return generation;
+}
+
+budget::currency_cache_stats budget::currency_cache_statistics(){
+    std::lock_guard<std::mutex> l(lock);
+
+    return stats;
 }
 
 double budget::exchange_rate(const std::string& from){
@@ -32,39 +268,53 @@ double budget::exchange_rate(const std::string& from, const std::string& to){
         return 1.0;
     } else {
         auto key = std::make_pair(from, to);
-        auto reverse_key = std::make_pair(to, from);
 
-        if (!exchanges.count(key)) {
-            httplib::Client cli("free.currencyconverterapi.com", 80);
+        {
+            std::unique_lock<std::mutex> l(lock);
 
-            std::string api_complete = "/api/v3/convert?q=" + from + "_" + to + "&compact=ultra";
+            load_cache();
 
-            auto res = cli.get(api_complete.c_str());
+            auto it = exchanges.find(key);
 
-            if (!res) {
-                std::cout << "Error accessing exchange rates (no response), setting exchange between " << from << " to " << to << " to 1/1" << std::endl;
-
-                exchanges[key] = 1.0;
-            } else if (res->status != 200) {
-                std::cout << "Error accessing exchange rates (not OK), setting exchange between " << from << " to " << to << " to 1/1" << std::endl;
+            if (it != exchanges.end()) {
+                ++stats.hits;
+                return it->second;
+            }
 
-                exchanges[key] = 1.0;
-            } else {
-                auto& buffer = res->body;
+            ++stats.misses;
 
-                if (buffer.find(':') == std::string::npos || buffer.find('}') == std::string::npos) {
-                    std::cout << "Error parsing exchange rates, setting exchange between " << from << " to " << to << " to 1/1" << std::endl;
+            // The rates that could not be fetched are only tried again on refresh
+            if (failed.count(key)) {
+                return 1.0;
+            }
 
-                    exchanges[key] = 1.0;
-                } else {
-                    std::string ratio_result(buffer.begin() + buffer.find(':') + 1, buffer.begin() + buffer.find('}'));
+            // The server never waits for the rate, it will be fetched in
+            // the background and used as soon as it's available
+            if (is_server_running()) {
+                pending.insert(key);
 
-                    exchanges[key]         = atof(ratio_result.c_str());
-                    exchanges[reverse_key] = 1.0 / exchanges[key];
+                if (!fetching) {
+                    fetching = true;
+                    std::thread([](){ fetch_pending(); }).detach();
                 }
+
+                return 1.0;
             }
         }
 
-        return exchanges[key];
+        double rate = 1.0;
+        bool fetched = fetch_exchange_rate(from, to, rate);
+
+        std::lock_guard<std::mutex> l(lock);
+
+        if (!fetched) {
+            failed.insert(key);
+            return 1.0;
+        }
+
+        store_exchange_rate(key, rate);
+        save_cache();
+
+        return rate;
     }
 }
@@ -23,18 +23,30 @@ budget::date budget::local_day(){
         static_cast<date_type>(timeval->tm_mday)};
 }
 
+namespace {
+
+// Parse the given field of a date, without creating a substring
+budget::date_type date_field(const std::string& str, size_t pos, size_t length){
+    auto first = str.data() + std::min(pos, str.size());
+    auto last  = str.data() + std::min(pos + length, str.size());
+
+    return budget::parse_integer<budget::date_type>(first, last);
+}
+
+} //end of anonymous namespace
+
 budget::date budget::from_string(const std::string& str){
-    auto y = year(to_number<unsigned short>(str.substr(0, 4)));
-    auto m = month(to_number<unsigned short>(str.substr(5, 2)));
-    auto d = day(to_number<unsigned short>(str.substr(8, 2)));
+    auto y = year(date_field(str, 0, 4));
+    auto m = month(date_field(str, 5, 2));
+    auto d = day(date_field(str, 8, 2));
 
     return {y, m, d};
 }
 
 budget::date budget::from_iso_string(const std::string& str){
-    auto y = year(to_number<unsigned short>(str.substr(0, 4)));
-    auto m = month(to_number<unsigned short>(str.substr(4, 2)));
-    auto d = day(to_number<unsigned short>(str.substr(6, 2)));
+    auto y = year(date_field(str, 0, 4));
+    auto m = month(date_field(str, 4, 2));
+    auto d = day(date_field(str, 6, 2));
 
     return {y, m, d};
 }
@@ -145,7 +145,7 @@ void budget::debt_module::handle(const std::vector<std::string>& args){
 }
 
 void budget::load_debts(){
-    debts.load();
+    debts.ensure_loaded();
 }
 
 void budget::save_debts(){
@@ -199,6 +199,8 @@ void budget::migrate_debts_3_to_4(){
 }
 
 std::vector<debt>& budget::all_debts(){
+    debts.ensure_loaded();
+
     return debts.data;
 }
 
@@ -210,6 +212,10 @@ void budget::set_debts_next_id(size_t next_id){
     debts.next_id = next_id;
 }
 
+size_t budget::debts_generation(){
+    return debts.generation();
+}
+
 void budget::display_all_debts(budget::writer& w){
     w << title_begin << "All debts " << add_button("debts") << title_end;
 
@@ -286,3 +292,7 @@ debt& budget::debt_get(size_t id) {
 void budget::add_debt(budget::debt&& debt){
     debts.add(std::forward<budget::debt>(debt));
 }
+
+bool budget::edit_debt(debt& debt){
+    return debts.edit(debt);
+}
@@ -24,7 +24,38 @@ using namespace budget;
 
 namespace {
 
-static data_handler<earning> earnings { "earnings", "earnings.data" };
+/*!
+ * \brief Check that the account of an earning received in a batch exists
+ */
+bool check_account(const budget::earning& earning, std::string& error){
+    if (!budget::account_exists(earning.account)) {
+        error = "No account with id " + budget::to_string(earning.account);
+        return false;
+    }
+
+    return true;
+}
+
+static month_index<earning> earning_index;
+
+/*!
+ * \brief Keep the index of the earnings up to date with the modified entries
+ */
+void update_index(const std::vector<budget::earning>& data, size_t generation, data_change change, size_t position){
+    switch (change) {
+        case data_change::added:
+            earning_index.added(data, generation, position);
+            break;
+        case data_change::edited:
+            earning_index.edited(data, generation, position);
+            break;
+        case data_change::erased:
+            earning_index.erased(data, generation, position);
+            break;
+    }
+}
+
+static data_handler<earning> earnings { "earnings", "earnings.data", nullptr, check_account, update_index };
 
 } //end of anonymous namespace
 
@@ -132,7 +163,7 @@ void budget::earnings_module::handle(const std::vector<std::string>& args){
 }
 
 void budget::load_earnings(){
-    earnings.load();
+    earnings.ensure_loaded();
 }
 
 void budget::save_earnings(){
@@ -160,6 +191,8 @@ void budget::operator>>(const std::vector<std::string>& parts, earning& earning)
 }
 
 std::vector<earning>& budget::all_earnings(){
+    earnings.ensure_loaded();
+
     return earnings.data;
 }
 
@@ -171,21 +204,34 @@ void budget::set_earnings_next_id(size_t next_id){
     earnings.next_id = next_id;
 }
 
+size_t budget::earnings_generation(){
+    return earnings.generation();
+}
+
 void budget::add_earning(budget::earning&& earning){
     earnings.add(std::forward<budget::earning>(earning));
 }
 
+bool budget::edit_earning(earning& earning){
+    return earnings.edit(earning);
+}
+
 void budget::show_all_earnings(budget::writer& w){
     w << title_begin << "All Earnings " << add_button("earnings") << title_end;
 
-    std::vector<std::string> columns = {"ID", "Date", "Account", "Name", "Amount"};
-    std::vector<std::vector<std::string>> contents;
+    w.begin_table({{"ID", column_kind::id}, "Date", "Account", "Name", "Amount"});
 
     for(auto& earning : earnings.data){
-        contents.push_back({to_string(earning.id), to_string(earning.date), get_account(earning.account).name, earning.name, to_string(earning.amount)});
+        w.begin_table_row();
+        w.table_cell(earning.id);
+        w.table_cell(earning.date);
+        w.table_cell(get_account(earning.account).name);
+        w.table_cell(earning.name);
+        w.table_cell(earning.amount);
+        w.end_table_row();
     }
 
-    w.display_table(columns, contents);
+    w.end_table();
 }
 
 void budget::show_earnings(budget::month month, budget::year year, budget::writer& w){
@@ -248,3 +294,21 @@ earning& budget::earning_get(size_t id) {
 
     return earnings[id];
 }
+
+month_view<earning> budget::all_earnings_month(budget::year year, budget::month month){
+    earnings.ensure_loaded();
+
+    return earning_index.month(earnings.data, earnings.generation(), year, month);
+}
+
+month_view<earning> budget::all_earnings_month(size_t account_id, budget::year year, budget::month month){
+    earnings.ensure_loaded();
+
+    return earning_index.month(earnings.data, earnings.generation(), account_id, year, month);
+}
+
+month_view<earning> budget::all_earnings_between(budget::year year, budget::month sm, budget::month month){
+    earnings.ensure_loaded();
+
+    return earning_index.between(earnings.data, earnings.generation(), year, sm, month);
+}
@@ -18,13 +18,55 @@
 #include "utils.hpp"
 #include "console.hpp"
 #include "writer.hpp"
+#include "recurring.hpp"
 #include "budget_exception.hpp"
 
 using namespace budget;
 
 namespace {
 
-static data_handler<expense> expenses { "expenses", "expenses.data" };
+/*!
+ * \brief Generate the missing recurring expenses, as soon as the expenses
+ * are loaded. In server mode, the server takes charge of that.
+ */
+void generate_recurrings(){
+    if (!is_server_mode()) {
+        check_for_recurrings();
+    }
+}
+
+/*!
+ * \brief Check that the account of an expense received in a batch exists
+ */
+bool check_account(const budget::expense& expense, std::string& error){
+    if (!budget::account_exists(expense.account)) {
+        error = "No account with id " + budget::to_string(expense.account);
+        return false;
+    }
+
+    return true;
+}
+
+static month_index<expense> expense_index;
+
+/*!
+ * \brief Keep the index of the expenses up to date with the modified entries
+ */
+void update_index(const std::vector<budget::expense>& data, size_t generation, data_change change, size_t position){
+    switch (change) {
+        case data_change::added:
+            expense_index.added(data, generation, position);
+            break;
+        case data_change::edited:
+            expense_index.edited(data, generation, position);
+            break;
+        case data_change::erased:
+            expense_index.erased(data, generation, position);
+            break;
+    }
+}
+
+static data_handler<expense> expenses { "expenses", "expenses.data", generate_recurrings, check_account, update_index };
 
 void show_templates(){
     std::vector<std::string> columns = {"ID", "Account", "Name", "Amount"};
@@ -217,7 +259,7 @@ void budget::expenses_module::handle(const std::vector<std::string>& args){
 }
 
 void budget::load_expenses(){
-    expenses.load();
+    expenses.ensure_loaded();
 }
 
 void budget::save_expenses(){
@@ -253,6 +295,8 @@ void budget::operator>>(const std::vector<std::string>& parts, expense& expense)
 }
 
 std::vector<expense>& budget::all_expenses(){
+    expenses.ensure_loaded();
+
     return expenses.data;
 }
 
@@ -264,38 +308,65 @@ void budget::set_expenses_next_id(size_t next_id){
     expenses.next_id = next_id;
 }
 
+size_t budget::expenses_generation(){
+    return expenses.generation();
+}
+
+void budget::begin_expenses_batch(){
+    expenses.begin_batch();
+}
+
+bool budget::commit_expenses_batch(){
+    return expenses.commit_batch();
+}
+
 void budget::show_all_expenses(budget::writer& w){
     w << title_begin << "All Expenses " << add_button("expenses") << title_end;
 
-    std::vector<std::string> columns = {"ID", "Date", "Account", "Name", "Amount", "Edit"};
-    std::vector<std::vector<std::string>> contents;
+    w.begin_table({{"ID", column_kind::id}, "Date", "Account", "Name", "Amount", {"Edit", column_kind::edit}});
 
     for(auto& expense : expenses.data){
-        contents.push_back({to_string(expense.id), to_string(expense.date), get_account(expense.account).name,
-            expense.name, to_string(expense.amount), "::edit::expenses::" + to_string(expense.id)});
+        w.begin_table_row();
+        w.table_cell(expense.id);
+        w.table_cell(expense.date);
+        w.table_cell(get_account(expense.account).name);
+        w.table_cell(expense.name);
+        w.table_cell(expense.amount);
+        w.table_edit_cell("expenses", expense.id);
+        w.end_table_row();
     }
 
-    w.display_table(columns, contents);
+    w.end_table();
 }
 
 void budget::search_expenses(const std::string& search, budget::writer& w){
     w << title_begin << "Results" << title_end;
 
-    std::vector<std::string> columns = {"ID", "Date", "Account", "Name", "Amount", "Edit"};
-    std::vector<std::vector<std::string>> contents;
-
     money total;
     size_t count = 0;
 
     auto l_search = search;
     std::transform(l_search.begin(), l_search.end(), l_search.begin(), ::tolower);
 
+    std::string l_name;
+
     for(auto& expense : expenses.data){
-        auto l_name = expense.name;
+        l_name.assign(expense.name);
         std::transform(l_name.begin(), l_name.end(), l_name.begin(), ::tolower);
 
         if(l_name.find(l_search) != std::string::npos){
-            contents.push_back({to_string(expense.id), to_string(expense.date), get_account(expense.account).name, expense.name, to_string(expense.amount), "::edit::expenses::" + to_string(expense.id)});
+            if(count == 0){
+                w.begin_table({{"ID", column_kind::id}, "Date", "Account", "Name", "Amount", {"Edit", column_kind::edit}});
+            }
+
+            w.begin_table_row();
+            w.table_cell(expense.id);
+            w.table_cell(expense.date);
+            w.table_cell(get_account(expense.account).name);
+            w.table_cell(expense.name);
+            w.table_cell(expense.amount);
+            w.table_edit_cell("expenses", expense.id);
+            w.end_table_row();
 
             total += expense.amount;
             ++count;
@@ -305,9 +376,18 @@ void budget::search_expenses(const std::string& search, budget::writer& w){
     if(count == 0){
         w << "No expenses found" << end_of_line;
     } else {
-        contents.push_back({"", "", "", "Total", to_string(total), ""});
-
-        w.display_table(columns, contents, 1, {}, 0, 1);
+        w.begin_table_footer();
+
+        w.begin_table_row();
+        w.table_cell(std::string());
+        w.table_cell(std::string());
+        w.table_cell(std::string());
+        w.table_cell(std::string("Total"));
+        w.table_cell(total);
+        w.table_cell(std::string());
+        w.end_table_row();
+
+        w.end_table();
     }
 }
 
@@ -371,3 +451,21 @@ expense& budget::expense_get(size_t id) {
 
     return expenses[id];
 }
+
+month_view<expense> budget::all_expenses_month(budget::year year, budget::month month){
+    expenses.ensure_loaded();
+
+    return expense_index.month(expenses.data, expenses.generation(), year, month);
+}
+
+month_view<expense> budget::all_expenses_month(size_t account_id, budget::year year, budget::month month){
+    expenses.ensure_loaded();
+
+    return expense_index.month(expenses.data, expenses.generation(), account_id, year, month);
+}
+
+month_view<expense> budget::all_expenses_between(budget::year year, budget::month sm, budget::month month){
+    expenses.ensure_loaded();
+
+    return expense_index.between(expenses.data, expenses.generation(), year, sm, month);
+}
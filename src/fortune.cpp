@@ -227,11 +227,13 @@ void budget::fortune_module::handle(const std::vector<std::string>& args){
 }
 
 std::vector<fortune>& budget::all_fortunes(){
+    fortunes.ensure_loaded();
+
     return fortunes.data;
 }
 
 void budget::load_fortunes(){
-    fortunes.load();
+    fortunes.ensure_loaded();
 }
 
 void budget::save_fortunes(){
@@ -264,6 +266,10 @@ void budget::set_fortunes_next_id(size_t next_id){
     fortunes.next_id = next_id;
 }
 
+size_t budget::fortunes_generation(){
+    return fortunes.generation();
+}
+
 bool budget::fortune_exists(size_t id){
     return fortunes.exists(id);
 }
@@ -287,3 +293,7 @@ fortune& budget::fortune_get(size_t id) {
 void budget::add_fortune(budget::fortune&& fortune){
     fortunes.add(std::forward<budget::fortune>(fortune));
 }
+
+bool budget::edit_fortune(fortune& fortune){
+    return fortunes.edit(fortune);
+}
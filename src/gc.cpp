@@ -20,6 +20,7 @@
 #include "recurring.hpp"
 #include "assets.hpp"
 #include "config.hpp"
+#include "loader.hpp"
 
 using namespace budget;
 
@@ -159,15 +160,10 @@ void gc_assets(){
 } //end of anonymous namespace
 
 void budget::gc_module::load(){
-    load_accounts();
-    load_expenses();
-    load_earnings();
-    load_debts();
-    load_fortunes();
-    load_wishes();
-    load_objectives();
-    load_recurrings();
-    load_assets();
+    load_concurrently({
+        load_accounts, load_expenses, load_earnings, load_debts, load_fortunes,
+        load_wishes, load_objectives, load_recurrings, load_assets
+    });
 }
 
 void budget::gc_module::unload(){
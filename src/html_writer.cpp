@@ -15,21 +15,24 @@
 
 namespace {
 
-std::string success_to_string(int success) {
+template <typename Stream>
+void write_success(Stream& ss, int success) {
     success = std::min(success, 100);
     success = std::max(success, 0);
 
-    std::stringstream ss;
-
     ss << R"=====(<div class="progress">)=====";
     ss << R"=====(<div class="progress-bar" role="progressbar" style="width:)=====" << success << R"=====(%;" aria-valuenow=")=====" << success << R"=====(" aria-valuemin="0" aria-valuemax="100">)=====" << success << R"=====(%</div>)=====";
     ss << R"=====(</div>)=====";
+}
 
+std::string success_to_string(int success) {
+    std::stringstream ss;
+    write_success(ss, success);
     return ss.str();
 }
 
-std::string edit_to_string(const std::string& module, const std::string& id){
-    std::stringstream ss;
+template <typename Stream, typename Id>
+void write_edit(Stream& ss, const std::string& module, const Id& id){
 
     // Add the delete button
     ss << R"=====(<form class="small-form-inline" method="POST" action="/api/)=====";
@@ -54,11 +57,36 @@ std::string edit_to_string(const std::string& module, const std::string& id){
     ss << R"=====(">)=====";
     ss << R"=====(<button type="submit" aria-label="Edit" class="btn btn-sm btn-warning oi oi-pencil"></button>)=====";
     ss << R"=====(</form>)=====";
+}
 
+std::string edit_to_string(const std::string& module, const std::string& id){
+    std::stringstream ss;
+    write_edit(ss, module, id);
     return ss.str();
 }
 
+bool starts_with(const std::string& value, const char* prefix, size_t n){
+    return value.size() >= n && value.compare(0, n, prefix) == 0;
+}
+
+const char* style_color(budget::cell_style style){
+    switch (style) {
+        case budget::cell_style::red:
+            return "red";
+        case budget::cell_style::green:
+            return "green";
+        case budget::cell_style::blue:
+            return "blue";
+        default:
+            return nullptr;
+    }
+}
+
 std::string html_format(budget::html_writer& w, const std::string& v){
+    if(v.size() < 5 || v[0] != ':' || v[1] != ':'){
+        return v;
+    }
+
     if(v.substr(0, 5) == "::red"){
         auto value = v.substr(5);
 
@@ -365,12 +393,12 @@ void budget::html_writer::display_table(std::vector<std::string>& columns, std::
 
     for (size_t i = 0; i < columns.size(); ++i) {
         for (auto& row : contents) {
-            if (row[i].size() >= 9 && row[i].substr(0, 9) == "::success") {
+            if (starts_with(row[i], "::success", 9)) {
                 extend = i;
                 break;
             }
 
-            if (row[i].size() >= 6 && row[i].substr(0, 6) == "::edit") {
+            if (starts_with(row[i], "::edit", 6)) {
                 edit = i;
                 break;
             }
@@ -503,6 +531,141 @@ bool budget::html_writer::is_web() {
     return true;
 }
 
+void budget::html_writer::begin_table(std::vector<table_column> columns){
+    table_columns = std::move(columns);
+    table_in_foot = false;
+
+    os << "<div class=\"table-responsive\">";
+    os << "<table class=\"table table-sm small-text\">";
+
+    os << "<thead>";
+    os << "<tr>";
+
+    for (auto& column : table_columns) {
+        if (column.kind == column_kind::id) {
+            continue;
+        }
+
+        if (column.kind == column_kind::success) {
+            os << "<th class=\"extend-only\">" << column.name << "</th>";
+        } else if (column.kind == column_kind::edit) {
+            os << "<th class=\"not-sortable\">" << column.name << "</th>";
+        } else {
+            os << "<th>" << column.name << "</th>";
+        }
+    }
+
+    os << "</tr>";
+    os << "</thead>";
+
+    os << "<tbody>";
+}
+
+void budget::html_writer::begin_table_row(){
+    current_column = 0;
+
+    os << "<tr>";
+}
+
+void budget::html_writer::end_table_row(){
+    os << "</tr>";
+}
+
+void budget::html_writer::begin_table_footer(){
+    table_in_foot = true;
+
+    os << "</tbody>";
+    os << "<tfoot>";
+}
+
+void budget::html_writer::end_table(){
+    os << (table_in_foot ? "</tfoot>" : "</tbody>");
+    os << "</table>";
+    os << "</div>"; // table-responsive
+
+    table_columns.clear();
+}
+
+bool budget::html_writer::next_table_cell(){
+    cpp_assert(current_column < table_columns.size(), "Too many cells in the row");
+
+    return table_columns[current_column++].kind != column_kind::id;
+}
+
+void budget::html_writer::table_cell(const std::string& value, cell_style style){
+    if (!next_table_cell()) {
+        return;
+    }
+
+    // Trim the value without copying it
+    auto first = value.find_first_not_of(" \t\n");
+
+    if (first == std::string::npos) {
+        os << "<td>&nbsp;</td>";
+        return;
+    }
+
+    auto last = value.find_last_not_of(" \t\n");
+
+    os << "<td>";
+
+    if (auto color = style_color(style)) {
+        os << "<span style=\"color:" << color << ";\">";
+        os.write(value.data() + first, last - first + 1);
+        os << "</span>";
+    } else {
+        os.write(value.data() + first, last - first + 1);
+    }
+
+    os << "</td>";
+}
+
+void budget::html_writer::table_cell(const budget::money& value, cell_style style){
+    if (!next_table_cell()) {
+        return;
+    }
+
+    os << "<td>";
+
+    if (auto color = style_color(style)) {
+        os << "<span style=\"color:" << color << ";\">" << value << "</span>";
+    } else {
+        os << value;
+    }
+
+    os << "</td>";
+}
+
+void budget::html_writer::table_cell(const budget::date& value){
+    if (next_table_cell()) {
+        os << "<td>" << value << "</td>";
+    }
+}
+
+void budget::html_writer::table_cell(size_t value){
+    if (next_table_cell()) {
+        os << "<td>" << value << "</td>";
+    }
+}
+
+void budget::html_writer::table_success_cell(unsigned long success){
+    if (next_table_cell()) {
+        os << "<td>";
+        write_success(os, success);
+        os << "</td>";
+    }
+}
+
+void budget::html_writer::table_edit_cell(const std::string& module, size_t id){
+    if (next_table_cell()) {
+        use_module("open-iconic");
+
+        os << "<td>";
+        write_edit(os, module, id);
+        os << "</td>";
+    }
+}
+
 void budget::html_writer::display_graph(const std::string& title, std::vector<std::string>& categories, std::vector<std::string> series_names, std::vector<std::vector<float>>& series_values){
     use_module("highcharts");
 
@@ -0,0 +1,102 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+#include "loader.hpp"
+
+namespace {
+
+// All the following variables are protected by the lock
+std::mutex lock;
+bool loading = false;
+std::vector<std::pair<size_t, budget::loader_function>> deferred_hooks;
+
+// Index of the load function being run by the current thread
+thread_local size_t current_loader = 0;
+
+} // end of anonymous namespace
+
+void budget::load_concurrently(const std::vector<loader_function>& loaders){
+    {
+        std::lock_guard<std::mutex> l(lock);
+        loading = true;
+    }
+
+    std::vector<std::exception_ptr> errors(loaders.size());
+    std::atomic<size_t> next(0);
+
+    auto worker = [&](){
+        size_t i;
+
+        while ((i = next++) < loaders.size()) {
+            current_loader = i;
+
+            try {
+                loaders[i]();
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    size_t threads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), loaders.size());
+
+    std::vector<std::thread> pool;
+
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+
+    // The current thread takes its share of the work too
+    worker();
+
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    std::vector<std::pair<size_t, loader_function>> hooks;
+
+    {
+        std::lock_guard<std::mutex> l(lock);
+
+        loading = false;
+        hooks.swap(deferred_hooks);
+    }
+
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::stable_sort(hooks.begin(), hooks.end(), [](auto& lhs, auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    for (auto& hook : hooks) {
+        hook.second();
+    }
+}
+
+void budget::run_after_loading(loader_function hook){
+    {
+        std::lock_guard<std::mutex> l(lock);
+
+        if (loading) {
+            deferred_hooks.emplace_back(current_loader, hook);
+            return;
+        }
+    }
+
+    hook();
+}
@@ -20,19 +20,14 @@ money budget::parse_money(const std::string& money_string){
     int dollars = 0;
     int cents = 0;
 
-    try {
-        if(dot_pos == std::string::npos){
-            dollars = to_number<int>(money_string);
-        } else {
-            dollars = to_number<int>(money_string.substr(0, dot_pos));
+    auto first = money_string.data();
+    auto last  = money_string.data() + money_string.size();
 
-            auto cents_str = money_string.substr(dot_pos+1, money_string.size() - dot_pos);
-            cents = to_number<int>(cents_str);
-        }
-    } catch (std::invalid_argument& e){
-        throw budget::budget_exception("\"" + money_string + "\" is not a valid amount of money");
-    } catch (std::out_of_range& e){
-        throw budget::budget_exception("\"" + money_string + "\" is not a valid amount of money");
+    if(dot_pos == std::string::npos){
+        dollars = parse_integer<int>(first, last);
+    } else {
+        dollars = parse_integer<int>(first, first + dot_pos);
+        cents   = parse_integer<int>(first + dot_pos + 1, last);
     }
 
     return {dollars, cents};
@@ -76,8 +71,8 @@ std::string budget::to_flat_string(const money& amount){
 }
 
 budget::money budget::random_money(size_t min, size_t max){
-    static std::random_device rd;
-    static std::mt19937_64 engine(rd());
+    static thread_local std::random_device rd;
+    static thread_local std::mt19937_64 engine(rd());
 
     std::uniform_int_distribution<int> dollars_dist(min, max);
     std::uniform_int_distribution<int> cents_dist(0, 99);
@@ -86,8 +81,8 @@ budget::money budget::random_money(size_t min, size_t max){
 }
 
 std::string budget::random_name(size_t length){
-    static std::random_device rd;
-    static std::mt19937_64 engine(rd());
+    static thread_local std::random_device rd;
+    static thread_local std::mt19937_64 engine(rd());
 
     std::uniform_int_distribution<int> letters_dist(0, 25);
 
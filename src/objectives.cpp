@@ -8,6 +8,7 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <mutex>
 
 #include "objectives.hpp"
 #include "expenses.hpp"
@@ -22,6 +23,7 @@
 #include "budget_exception.hpp"
 #include "compute.hpp"
 #include "writer.hpp"
+#include "loader.hpp"
 
 using namespace budget;
 
@@ -29,6 +31,37 @@ namespace {
 
 static data_handler<objective> objectives { "objectives", "objectives.data" };
 
+/*!
+ * \brief The compiled objectives, compiled again when the generation of the
+ * objectives changes.
+ */
+struct compiled_cache {
+    std::vector<budget::compiled_objective> get() {
+        std::lock_guard<std::mutex> l(lock);
+
+        if (!valid || generation != objectives.generation()) {
+            compiled.clear();
+
+            for (auto& objective : objectives.data) {
+                compiled.push_back(budget::compile_objective(objective));
+            }
+
+            generation = objectives.generation();
+            valid      = true;
+        }
+
+        return compiled;
+    }
+
+private:
+    std::mutex lock;
+    std::vector<budget::compiled_objective> compiled;
+    size_t generation = 0;
+    bool valid        = false;
+};
+
+static compiled_cache compiled_objectives_cache;
+
 void edit(budget::objective& objective){
     edit_string(objective.name, "Name", not_empty_checker());
     edit_string_complete(objective.type, "Type", {"monthly","yearly"}, not_empty_checker(), one_of_checker({"monthly","yearly"}));
@@ -89,9 +122,11 @@ void budget::yearly_objective_status(budget::writer& w, bool lines, bool full_al
         std::vector<std::string> columns = {"Objective", "Status", "Progress"};
         std::vector<std::vector<std::string>> contents;
 
-        for (auto& objective : objectives.data) {
-            if (objective.type == "yearly") {
-                contents.push_back({objective.name, get_status(year_status, objective), get_success(year_status, objective)});
+        auto compiled = compiled_objectives();
+
+        for (size_t i = 0; i < objectives.data.size(); ++i) {
+            if (compiled[i].period == objective_period::yearly) {
+                contents.push_back({objectives.data[i].name, get_status(year_status, compiled[i]), get_success(year_status, compiled[i])});
             }
         }
 
@@ -107,18 +142,28 @@ void budget::monthly_objective_status(budget::writer& w){
     auto current_year  = today.year();
     auto sm            = start_month(current_year);
 
-    for (auto& objective : objectives.data) {
-        if (objective.type == "monthly") {
-            std::vector<std::string> columns = {objective.name, "Status", "Progress"};
+    // Compute the month statuses once for all the objectives
+    std::vector<budget::status> statuses;
+
+    for (unsigned short i = sm; i <= current_month; ++i) {
+        statuses.push_back(budget::compute_month_status(current_year, budget::month(i)));
+    }
+
+    auto compiled = compiled_objectives();
+
+    for (size_t o = 0; o < objectives.data.size(); ++o) {
+        auto& compiled_objective = compiled[o];
+
+        if (compiled_objective.period == objective_period::monthly) {
+            std::vector<std::string> columns = {objectives.data[o].name, "Status", "Progress"};
             std::vector<std::vector<std::string>> contents;
 
-            for (unsigned short i = sm; i <= current_month; ++i) {
-                budget::month month = i;
+            auto successes = compute_successes(compiled_objective, statuses);
 
-                // Compute the month status
-                auto status = budget::compute_month_status(current_year, month);
+            for (size_t i = 0; i < statuses.size(); ++i) {
+                budget::month month = sm + i;
 
-                contents.push_back({to_string(month), get_status(status, objective), get_success(status, objective)});
+                contents.push_back({to_string(month), get_status(statuses[i], compiled_objective), "::success" + std::to_string(successes[i])});
             }
 
             w.display_table(columns, contents);
@@ -164,54 +209,112 @@ void budget::current_monthly_objective_status(budget::writer& w, bool full_align
     // Compute the month status
     auto status = budget::compute_month_status(today.year(), today.month());
 
-    for (auto& objective : objectives.data) {
-        if (objective.type == "monthly") {
-            contents.push_back({objective.name, get_status(status, objective), get_success(status, objective)});
+    auto compiled = compiled_objectives();
+
+    for (size_t i = 0; i < objectives.data.size(); ++i) {
+        if (compiled[i].period == objective_period::monthly) {
+            contents.push_back({objectives.data[i].name, get_status(status, compiled[i]), get_success(status, compiled[i])});
         }
     }
 
     w.display_table(columns, contents);
 }
 
-int budget::compute_success(const budget::status& status, const budget::objective& objective){
-    auto amount = objective.amount;
+int budget::compiled_objective::basis(const budget::status& status) const {
+    switch (source) {
+        case objective_source::expenses:
+            return status.expenses.dollars();
 
-    budget::money basis;
-    if(objective.source == "expenses"){
-        basis = status.expenses;
-    } else if (objective.source == "earnings") {
-        basis = status.earnings;
-    } else if (objective.source == "savings_rate") {
-        double savings_rate = 0.0;
+        case objective_source::earnings:
+            return status.earnings.dollars();
 
-        if(status.balance.dollars() > 0){
-            savings_rate = 100 * (status.balance.dollars() / double((status.budget + status.earnings).dollars()));
+        case objective_source::savings_rate: {
+            double savings_rate = 0.0;
+
+            if (status.balance.dollars() > 0) {
+                savings_rate = 100 * (status.balance.dollars() / double((status.budget + status.earnings).dollars()));
+            }
+
+            return int(savings_rate);
         }
 
-        basis = budget::money(int(savings_rate));
-    } else {
-        basis = status.balance;
+        default:
+            return status.balance.dollars();
     }
+}
+
+int budget::compiled_objective::success(const budget::status& status) const {
+    auto value = basis(status);
 
     int success = 0;
-    if(objective.op == "min"){
-        auto percent = basis.dollars() / static_cast<double>(amount.dollars());
+    if (op == objective_op::min) {
+        auto percent = value / static_cast<double>(amount);
         success = percent * 100;
-    } else if(objective.op == "max"){
-        auto percent = amount.dollars() / static_cast<double>(basis.dollars());
+    } else if (op == objective_op::max) {
+        auto percent = amount / static_cast<double>(value);
         success = percent * 100;
     }
 
-    success = std::max(0, success);
+    return std::max(0, success);
+}
+
+budget::compiled_objective budget::compile_objective(const objective& objective){
+    compiled_objective compiled;
 
-    return success;
+    compiled.id     = objective.id;
+    compiled.amount = objective.amount.dollars();
+
+    if (objective.type == "monthly") {
+        compiled.period = objective_period::monthly;
+    } else if (objective.type == "yearly") {
+        compiled.period = objective_period::yearly;
+    } else {
+        compiled.period = objective_period::none;
+    }
+
+    if (objective.source == "expenses") {
+        compiled.source = objective_source::expenses;
+    } else if (objective.source == "earnings") {
+        compiled.source = objective_source::earnings;
+    } else if (objective.source == "savings_rate") {
+        compiled.source = objective_source::savings_rate;
+    } else {
+        compiled.source = objective_source::balance;
+    }
+
+    if (objective.op == "min") {
+        compiled.op = objective_op::min;
+    } else if (objective.op == "max") {
+        compiled.op = objective_op::max;
+    } else {
+        compiled.op = objective_op::none;
+    }
+
+    return compiled;
+}
+
+std::vector<budget::compiled_objective> budget::compiled_objectives(){
+    objectives.ensure_loaded();
+
+    return compiled_objectives_cache.get();
+}
+
+std::vector<int> budget::compute_successes(const compiled_objective& objective, const std::vector<budget::status>& statuses){
+    std::vector<int> successes(statuses.size());
+
+    for (size_t i = 0; i < statuses.size(); ++i) {
+        successes[i] = objective.success(statuses[i]);
+    }
+
+    return successes;
+}
+
+int budget::compute_success(const budget::status& status, const budget::objective& objective){
+    return compile_objective(objective).success(status);
 }
 
 void budget::objectives_module::load(){
-    load_expenses();
-    load_earnings();
-    load_accounts();
-    load_objectives();
+    load_concurrently({load_expenses, load_earnings, load_accounts, load_objectives});
 }
 
 void budget::objectives_module::unload(){
@@ -275,7 +378,7 @@ void budget::objectives_module::handle(const std::vector<std::string>& args){
 }
 
 void budget::load_objectives(){
-    objectives.load();
+    objectives.ensure_loaded();
 }
 
 void budget::save_objectives(){
@@ -313,6 +416,8 @@ void budget::operator>>(const std::vector<std::string>& parts, objective& object
 }
 
 std::vector<objective>& budget::all_objectives(){
+    objectives.ensure_loaded();
+
     return objectives.data;
 }
 
@@ -324,6 +429,10 @@ void budget::set_objectives_next_id(size_t next_id){
     objectives.next_id = next_id;
 }
 
+size_t budget::objectives_generation(){
+    return objectives.generation();
+}
+
 void budget::list_objectives(budget::writer& w){
     w << title_begin << "Objectives " << add_button("objectives") << title_end;
 
@@ -402,35 +511,28 @@ void budget::add_objective(budget::objective&& objective){
     objectives.add(std::forward<budget::objective>(objective));
 }
 
-std::string budget::get_status(const budget::status& status, const budget::objective& objective){
-    std::string result;
-
-    budget::money basis;
-    if(objective.source == "expenses"){
-        basis = status.expenses;
-    } else if (objective.source == "earnings") {
-        basis = status.earnings;
-    } else if (objective.source == "savings_rate") {
-        double savings_rate = 0.0;
-
-        if(status.balance.dollars() > 0){
-            savings_rate = 100 * (status.balance.dollars() / double((status.budget + status.earnings).dollars()));
-        }
+bool budget::edit_objective(objective& objective){
+    return objectives.edit(objective);
+}
 
-        basis = budget::money(int(savings_rate));
-    } else {
-        basis = status.balance;
-    }
+std::string budget::get_status(const budget::status& status, const budget::compiled_objective& objective){
+    std::string result;
 
-    result += to_string(basis.dollars());
+    result += to_string(objective.basis(status));
     result += "/";
-    result += to_string(objective.amount.dollars());
+    result += to_string(objective.amount);
 
     return result;
 }
 
-std::string budget::get_success(const budget::status& status, const budget::objective& objective){
-    auto success = compute_success(status, objective);
+std::string budget::get_success(const budget::status& status, const budget::compiled_objective& objective){
+    return "::success" + std::to_string(objective.success(status));
+}
 
-    return "::success" + std::to_string(success);
+std::string budget::get_status(const budget::status& status, const budget::objective& objective){
+    return get_status(status, compile_objective(objective));
+}
+
+std::string budget::get_success(const budget::status& status, const budget::objective& objective){
+    return get_success(status, compile_objective(objective));
 }
@@ -22,6 +22,7 @@
 #include "budget_exception.hpp"
 #include "config.hpp"
 #include "writer.hpp"
+#include "loader.hpp"
 
 using namespace budget;
 
@@ -32,7 +33,7 @@ bool invalid_accounts_all(){
 
     auto today = budget::local_day();
 
-    std::vector<budget::account> previous = all_accounts(sy, start_month(sy));
+    auto previous = all_accounts(sy, start_month(sy));
 
     for(unsigned short j = sy; j <= today.year(); ++j){
         budget::year year = j;
@@ -71,7 +72,7 @@ bool invalid_accounts_all(){
 bool invalid_accounts(budget::year year){
     auto sm = start_month(year);
 
-    std::vector<budget::account> previous = all_accounts(year, sm);;
+    auto previous = all_accounts(year, sm);
 
     for(unsigned short i = sm + 1; i < 13; ++i){
         budget::month month = i;
@@ -97,7 +98,7 @@ bool invalid_accounts(budget::year year){
             }
         }
 
-        previous = std::move(current_accounts);
+        previous = current_accounts;
     }
 
     return false;
@@ -491,9 +492,7 @@ void display_values(budget::writer& w, budget::year year, const std::string& tit
 constexpr const std::array<std::pair<const char*, const char*>, 1> budget::module_traits<budget::overview_module>::aliases;
 
 void budget::overview_module::load(){
-    load_accounts();
-    load_expenses();
-    load_earnings();
+    load_concurrently({load_accounts, load_expenses, load_earnings});
 }
 
 void budget::overview_module::handle(std::vector<std::string>& args) {
@@ -877,7 +876,9 @@ void budget::display_balance(budget::writer& w, budget::year year, bool relaxed,
 }
 
 void budget::display_month_overview(budget::month month, budget::year year, budget::writer& writer){
-    auto accounts = all_accounts(year, month);
+    auto valid_accounts = all_accounts(year, month);
+
+    std::vector<budget::account> accounts(valid_accounts.begin(), valid_accounts.end());
 
     writer << title_begin << "Overview of " << month << " " << year << budget::year_month_selector{"overview", year, month} << title_end;
 
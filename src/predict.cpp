@@ -20,6 +20,7 @@
 #include "budget_exception.hpp"
 #include "config.hpp"
 #include "writer.hpp"
+#include "loader.hpp"
 
 using namespace budget;
 
@@ -90,9 +91,7 @@ void predict_overview(){
 } // end of anonymous namespace
 
 void budget::predict_module::load(){
-    load_accounts();
-    load_expenses();
-    load_earnings();
+    load_concurrently({load_accounts, load_expenses, load_earnings});
 }
 
 void budget::predict_module::handle(std::vector<std::string>& args){
@@ -0,0 +1,99 @@
+//=======================================================================
+// Copyright (c) 2013-2018 Baptiste Wicht.
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#include <cmath>
+#include <algorithm>
+
+#include "projection.hpp"
+
+namespace {
+
+// The projection is only used over a few centuries at most
+constexpr double max_months = 1e6;
+
+/*!
+ * \brief The net worth of the scenario after the given number of months
+ */
+double projected_nw(const budget::fi_scenario& scenario, double monthly_return, double months){
+    if (monthly_return == 0.0) {
+        return scenario.nw + months * scenario.savings;
+    }
+
+    auto growth = std::pow(1.0 + monthly_return, months);
+
+    return scenario.nw * growth + scenario.savings * (growth - 1.0) / monthly_return;
+}
+
+/*!
+ * \brief Estimate the (fractional) number of months to FI. The net worth
+ * follows nw(n) + k = (1 + r)^n * (nw + k) with k = savings / r.
+ * \return The estimate, or a negative value if the target is never reached
+ */
+double estimate_months(const budget::fi_scenario& scenario, double monthly_return, double log_growth){
+    if (monthly_return == 0.0 || log_growth == 0.0) {
+        return scenario.savings > 0.0 ? (scenario.target - scenario.nw) / scenario.savings : -1.0;
+    }
+
+    auto k     = scenario.savings / monthly_return;
+    auto ratio = (scenario.target + k) / (scenario.nw + k);
+
+    if (!(ratio > 0.0)) {
+        return -1.0;
+    }
+
+    return std::log(ratio) / log_growth;
+}
+
+size_t months_to_fi(const budget::fi_scenario& scenario, double monthly_return, double log_growth){
+    if (scenario.nw >= scenario.target) {
+        return 0;
+    }
+
+    // Everything is lost each month, only the savings remain
+    if (monthly_return <= -1.0) {
+        return scenario.savings >= scenario.target ? 1 : budget::never_fi;
+    }
+
+    auto estimate = estimate_months(scenario, monthly_return, log_growth);
+
+    if (!std::isfinite(estimate) || estimate < 0.0 || estimate > max_months) {
+        return budget::never_fi;
+    }
+
+    // Correct the rounding errors of the estimate with the direct projection
+    size_t months = std::max(std::ceil(estimate), 1.0);
+
+    while (months > 1 && projected_nw(scenario, monthly_return, months - 1) >= scenario.target) {
+        --months;
+    }
+
+    while (projected_nw(scenario, monthly_return, months) < scenario.target) {
+        if (++months > max_months) {
+            return budget::never_fi;
+        }
+    }
+
+    return months;
+}
+
+} // end of anonymous namespace
+
+size_t budget::months_to_fi(const fi_scenario& scenario, double monthly_return){
+    return ::months_to_fi(scenario, monthly_return, std::log1p(monthly_return));
+}
+
+std::vector<size_t> budget::months_to_fi(const std::vector<fi_scenario>& scenarios, double monthly_return){
+    auto log_growth = std::log1p(monthly_return);
+
+    std::vector<size_t> months(scenarios.size());
+
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        months[i] = ::months_to_fi(scenarios[i], monthly_return, log_growth);
+    }
+
+    return months;
+}
@@ -53,6 +53,11 @@ void budget::check_for_recurrings(){
 
     bool changed = false;
 
+    // All the expenses are persisted at once
+    begin_expenses_batch();
+
+    recurrings.ensure_loaded();
+
     for (auto& recurring : recurrings.data) {
         auto l_year  = last_year(recurring);
 
@@ -92,6 +97,8 @@ void budget::check_for_recurrings(){
         }
     }
 
+    commit_expenses_batch();
+
     if (changed) {
         save_expenses();
     }
@@ -99,20 +106,6 @@ void budget::check_for_recurrings(){
     internal_config_remove("recurring:last_checked");
 }
 
-void budget::recurring_module::preload() {
-    // In server mode, there is no need to generate recurring expenses
-    // the server will take charge of that
-    if (is_server_mode()) {
-        return;
-    }
-
-    load_recurrings();
-    load_accounts();
-    load_expenses();
-
-    check_for_recurrings();
-}
-
 void budget::recurring_module::load() {
     // Only need to load in server mode
     if (is_server_mode()) {
@@ -219,7 +212,7 @@ void budget::recurring_module::handle(const std::vector<std::string>& args) {
 }
 
 void budget::load_recurrings() {
-    recurrings.load();
+    recurrings.ensure_loaded();
 }
 
 void budget::save_recurrings() {
@@ -324,6 +317,8 @@ budget::month budget::last_month(const budget::recurring& recurring, budget::yea
 }
 
 std::vector<recurring>& budget::all_recurrings() {
+    recurrings.ensure_loaded();
+
     return recurrings.data;
 }
 
@@ -335,6 +330,10 @@ void budget::set_recurrings_next_id(size_t next_id) {
     recurrings.next_id = next_id;
 }
 
+size_t budget::recurrings_generation(){
+    return recurrings.generation();
+}
+
 void budget::show_recurrings(budget::writer& w) {
     w << title_begin << "Recurring expenses " << add_button("recurrings") << title_end;
 
@@ -382,3 +381,7 @@ recurring& budget::recurring_get(size_t id) {
 void budget::add_recurring(budget::recurring&& recurring) {
     recurrings.add(std::forward<budget::recurring>(recurring));
 }
+
+bool budget::edit_recurring(recurring& recurring){
+    return recurrings.edit(recurring);
+}
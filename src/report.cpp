@@ -15,6 +15,7 @@
 #include "console.hpp"
 #include "writer.hpp"
 #include "date.hpp"
+#include "loader.hpp"
 
 using namespace budget;
 
@@ -43,9 +44,7 @@ void write(graph_type& graph, int row, int col, const std::string& value) {
 } //end of anonymous namespace
 
 void budget::report_module::load() {
-    load_accounts();
-    load_expenses();
-    load_earnings();
+    load_concurrently({load_accounts, load_expenses, load_earnings});
 }
 
 void budget::report_module::handle(const std::vector<std::string>& args) {
@@ -6,17 +6,27 @@
 //=======================================================================
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <array>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
 
 #include "retirement.hpp"
 #include "assets.hpp"
 #include "accounts.hpp"
 #include "expenses.hpp"
 #include "earnings.hpp"
+#include "compute.hpp"
 #include "budget_exception.hpp"
 #include "config.hpp"
 #include "console.hpp"
 #include "writer.hpp"
+#include "loader.hpp"
+#include "projection.hpp"
 
 using namespace budget;
 
@@ -25,15 +35,10 @@ namespace {
 constexpr size_t running_limit = 12;
 
 money running_expenses(budget::date d = budget::local_day()){
-    budget::date end = d - budget::days(d.day() - 1);
-    budget::date start = end - budget::months(running_limit);
-
     budget::money total;
 
-    for(auto& expense : all_expenses()){
-        if(expense.date >= start && expense.date < end){
-            total += expense.amount;
-        }
+    for (auto& status : compute_monthly_statuses(d - budget::months(running_limit), d - budget::months(1))) {
+        total += status.expenses;
     }
 
     return total;
@@ -42,33 +47,8 @@ money running_expenses(budget::date d = budget::local_day()){
 double running_savings_rate(budget::date sd = budget::local_day()){
     double savings_rate = 0.0;
 
-    for(size_t i = 1; i <= running_limit; ++i){
-        auto d = sd - budget::months(i);
-
-        budget::money expenses;
-
-        for (auto& expense : all_expenses()) {
-            if (expense.date.year() == d.year() && expense.date.month() == d.month()) {
-                expenses += expense.amount;
-            }
-        }
-
-        budget::money earnings;
-
-        for (auto& earning : all_earnings()) {
-            if (earning.date.year() == d.year() && earning.date.month() == d.month()) {
-                earnings += earning.amount;
-            }
-        }
-
-        budget::money income;
-
-        for (auto& account : all_accounts(d.year(), d.month())){
-            income += account.amount;
-        }
-
-        auto balance = income + earnings - expenses;
-        auto local   = balance / (income + earnings);
+    for (auto& status : compute_monthly_statuses(sd - budget::months(running_limit), sd - budget::months(1))) {
+        auto local = status.balance / (status.budget + status.earnings);
 
         if(local < 0){
             local = 0;
@@ -83,6 +63,7 @@ double running_savings_rate(budget::date sd = budget::local_day()){
 void retirement_set() {
     double wrate = 4.0;
     double roi = 4.0;
+    double volatility = 15.0;
 
     if(internal_config_contains("withdrawal_rate")){
         wrate = to_number<double>(internal_config_value("withdrawal_rate"));
@@ -92,21 +73,228 @@ void retirement_set() {
         roi = to_number<double>(internal_config_value("expected_roi"));
     }
 
+    if(internal_config_contains("return_volatility")){
+        volatility = to_number<double>(internal_config_value("return_volatility"));
+    }
+
     edit_double(wrate, "Withdrawal Rate (%)");
     edit_double(roi, "Expected Annual Return (%)");
+    edit_double(volatility, "Annual Return Volatility (%)");
 
     // Save the configuration
     internal_config_value("withdrawal_rate") = to_string(wrate);
     internal_config_value("expected_roi") = to_string(roi);
+    internal_config_value("return_volatility") = to_string(volatility);
+}
+
+std::string months_to_string(size_t months){
+    return months == never_fi ? "Never" : to_string(months);
+}
+
+std::string years_to_string(size_t months){
+    return months == never_fi ? "Never" : to_string(months / 12.0);
+}
+
+std::string fi_date_to_string(size_t months){
+    return months == never_fi ? "Never" : to_string(budget::local_day() + budget::months(months));
+}
+
+std::string saved_years_to_string(size_t base_months, size_t months){
+    if (base_months == never_fi) {
+        return months == never_fi ? "0" : "infinite";
+    }
+
+    if (months == never_fi) {
+        return "0";
+    }
+
+    return to_string((double(base_months) - double(months)) / 12.0);
+}
+
+constexpr size_t simulation_block   = 256;
+constexpr size_t simulation_horizon = 100 * 12;
+
+/*!
+ * \brief The source of the yearly returns and inflation of the simulated
+ * paths. Either bootstrapped from a historical series or drawn from a
+ * normal distribution of the returns, without inflation.
+ */
+struct return_source {
+    std::vector<double> returns;
+    std::vector<double> inflations;
+
+    double mean       = 0.0;
+    double volatility = 0.0;
+
+    bool bootstrap() const {
+        return !returns.empty();
+    }
+};
+
+/*!
+ * \brief Read the historical series from the retirement_returns_file, with
+ * one RETURN or RETURN:INFLATION line, in percent, per year.
+ */
+void load_historical_returns(return_source& source){
+    std::ifstream file(config_value("retirement_returns_file"));
+
+    std::string line;
+    while (file.good() && getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        auto parts = budget::split(line, ':');
+
+        double values[2] = {0.0, 0.0};
+
+        for (size_t i = 0; i < std::min<size_t>(parts.size(), 2); ++i) {
+            std::stringstream ss(parts[i]);
+            ss.imbue(std::locale::classic());
+            ss >> values[i];
+        }
+
+        source.returns.push_back(values[0] / 100.0);
+        source.inflations.push_back(values[1] / 100.0);
+    }
+}
+
+return_source make_return_source(double roi){
+    return_source source;
+
+    if (config_contains("retirement_returns_file")) {
+        load_historical_returns(source);
+    }
+
+    if (!source.bootstrap()) {
+        source.mean       = roi / 100.0;
+        source.volatility = 15.0 / 100.0;
+
+        if (internal_config_contains("return_volatility")) {
+            source.volatility = to_number<double>(internal_config_value("return_volatility")) / 100.0;
+        }
+    }
+
+    return source;
+}
+
+struct simulation_parameters {
+    double nw;      ///< The current net worth
+    double target;  ///< The net worth needed for FI, in today's money
+    double savings; ///< The yearly savings, in today's money
+    size_t paths;   ///< The number of simulated paths
+};
+
+/*!
+ * \brief Simulate one block of paths and store the month at which each path
+ * reaches FI. The paths are updated together, one month at a time, so that
+ * the inner loops are vectorized. Each block has its own generator, seeded
+ * by its index, so that the results do not depend on the number of threads.
+ */
+void simulate_block(const simulation_parameters& params, const return_source& source, size_t block, size_t* fi_months){
+    const size_t first = block * simulation_block;
+    const size_t count = std::min(simulation_block, params.paths - first);
+
+    std::mt19937_64 generator(block);
+    std::normal_distribution<double> normal(source.mean, std::max(source.volatility, 1e-9));
+    std::uniform_int_distribution<size_t> year_picker(0, std::max<size_t>(source.returns.size(), 1) - 1);
+
+    std::vector<double> nw(count, params.nw);
+    std::vector<double> target(count, params.target);
+    std::vector<double> savings(count, params.savings / 12);
+    std::vector<double> growth(count);
+    std::vector<double> inflation(count);
+
+    size_t remaining = count;
+
+    for (size_t i = 0; i < count; ++i) {
+        fi_months[first + i] = never_fi;
+
+        if (nw[i] >= target[i]) {
+            fi_months[first + i] = 0;
+            --remaining;
+        }
+    }
+
+    for (size_t month = 0; month < simulation_horizon && remaining; month += 12) {
+        for (size_t i = 0; i < count; ++i) {
+            if (source.bootstrap()) {
+                auto year    = year_picker(generator);
+                growth[i]    = 1.0 + source.returns[year] / 12;
+                inflation[i] = 1.0 + source.inflations[year] / 12;
+            } else {
+                growth[i]    = 1.0 + normal(generator) / 12;
+                inflation[i] = 1.0;
+            }
+        }
+
+        for (size_t m = 1; m <= 12; ++m) {
+            for (size_t i = 0; i < count; ++i) {
+                nw[i]      = nw[i] * growth[i] + savings[i];
+                savings[i] = savings[i] * inflation[i];
+                target[i]  = target[i] * inflation[i];
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                if (fi_months[first + i] == never_fi && nw[i] >= target[i]) {
+                    fi_months[first + i] = month + m;
+                    --remaining;
+                }
+            }
+        }
+    }
+}
+
+/*!
+ * \brief Simulate all the paths, with the blocks shared between all the cores.
+ * \return The sorted months to FI of all the paths
+ */
+std::vector<size_t> simulate_paths(const simulation_parameters& params, const return_source& source){
+    std::vector<size_t> fi_months(params.paths);
+
+    const size_t blocks = (params.paths + simulation_block - 1) / simulation_block;
+
+    std::atomic<size_t> next(0);
+
+    auto worker = [&](){
+        size_t block;
+
+        while ((block = next++) < blocks) {
+            simulate_block(params, source, block, fi_months.data());
+        }
+    };
+
+    size_t threads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), blocks);
+
+    std::vector<std::thread> pool;
+
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    std::sort(fi_months.begin(), fi_months.end());
+
+    return fi_months;
+}
+
+std::string fi_months_to_string(size_t months){
+    if (months == never_fi) {
+        return "Not within " + to_string(simulation_horizon / 12) + " years";
+    }
+
+    return to_string(months / 12.0) + " years (" + to_string(budget::local_day() + budget::months(months)) + ")";
 }
 
 } // end of anonymous namespace
 
 void budget::retirement_module::load() {
-    load_accounts();
-    load_assets();
-    load_expenses();
-    load_earnings();
+    load_concurrently({load_accounts, load_assets, load_expenses, load_earnings});
 }
 
 void budget::retirement_module::handle(std::vector<std::string>& args) {
@@ -123,6 +311,8 @@ void budget::retirement_module::handle(std::vector<std::string>& args) {
             retirement_set();
             std::cout << std::endl;
             retirement_status(w);
+        } else if (subcommand == "simulate") {
+            retirement_simulation(w);
         } else {
             throw budget_exception("Invalid subcommand \"" + subcommand + "\"");
         }
@@ -139,6 +329,52 @@ float budget::fi_ratio(budget::date d) {
     return nw / missing;
 }
 
+std::vector<budget::fi_ratio_point> budget::fi_ratio_timeline() {
+    std::vector<fi_ratio_point> timeline;
+
+    auto points = net_worth_timeline();
+
+    if (points->empty()) {
+        return timeline;
+    }
+
+    auto wrate = to_number<double>(internal_config_value("withdrawal_rate"));
+    auto years = double(int(100.0 / wrate));
+
+    auto first = points->front().date - budget::months(running_limit);
+    auto last  = points->back().date;
+
+    auto statuses = compute_monthly_statuses(first, last - budget::months(1));
+
+    // The running expenses of the month of statuses[current] are the sum
+    // of the running_limit months before it
+    size_t current = running_limit;
+    budget::money expenses;
+
+    for (size_t i = 0; i < running_limit; ++i) {
+        expenses += statuses[i].expenses;
+    }
+
+    for (auto& point : *points) {
+        if (!timeline.empty() && timeline.back().date.year() == point.date.year() && timeline.back().date.month() == point.date.month()) {
+            continue;
+        }
+
+        size_t month = 12 * (point.date.year() - first.year()) + point.date.month() - first.month();
+
+        for (; current < month; ++current) {
+            expenses += statuses[current].expenses;
+            expenses -= statuses[current - running_limit].expenses;
+        }
+
+        auto missing = years * expenses - point.net_worth;
+
+        timeline.push_back({point.date, float(point.net_worth / missing)});
+    }
+
+    return timeline;
+}
+
 void budget::retirement_status(budget::writer& w) {
     if (!w.is_web()) {
         if (!internal_config_contains("withdrawal_rate")) {
@@ -163,25 +399,38 @@ void budget::retirement_status(budget::writer& w) {
     auto income         = 12 * get_base_income();
     auto a_savings_rate = (income - expenses) / income;
 
-    size_t base_months   = 0;
-    size_t a_base_months = 0;
+    std::array<int, 5> rate_decs{1, 2, 5, 10, 20};
+    std::array<int, 5> exp_decs{10, 50, 100, 200, 500};
+
+    // All the scenarios are projected at once: the base and adjusted
+    // savings rates, then the increased savings rates and the decreased
+    // expenses
+
+    std::vector<fi_scenario> scenarios;
+
+    scenarios.push_back({double(nw), years * expenses, (savings_rate * income) / 12});
+    scenarios.push_back({double(nw), years * expenses, (a_savings_rate * income) / 12});
 
-    auto current_nw = nw;
-    while (current_nw < years * expenses) {
-        current_nw *= 1.0 + (roi / 100.0) / 12;
-        current_nw += (savings_rate * income) / 12;
+    // Note: this not totally correct since we ignore the
+    // correlation between the savings rate and the expenses
+
+    for (auto dec : rate_decs) {
+        auto dec_savings_rate = savings_rate + 0.01 * dec;
 
-        ++base_months;
+        scenarios.push_back({double(nw), years * expenses, (dec_savings_rate * income) / 12});
     }
 
-    current_nw = nw;
-    while (current_nw < years * expenses) {
-        current_nw *= 1.0 + (roi / 100.0) / 12;
-        current_nw += (a_savings_rate * income) / 12;
+    for (auto dec : exp_decs) {
+        auto new_savings_rate = (income - (expenses - dec * 12)) / income;
 
-        ++a_base_months;
+        scenarios.push_back({double(nw), years * (expenses - (dec * 12)), (new_savings_rate * income) / 12});
     }
 
+    auto months = months_to_fi(scenarios, (roi / 100.0) / 12);
+
+    auto base_months   = months[0];
+    auto a_base_months = months[1];
+
     std::vector<std::string> columns = {};
     std::vector<std::vector<std::string>> contents;
 
@@ -206,11 +455,10 @@ void budget::retirement_status(budget::writer& w) {
     contents.push_back({"Yearly savings"s, to_string(savings_rate * income) + " " + currency});
     contents.push_back({"FI Ratio"s, to_string(100 * (nw / missing)) + "%"});
 
-    auto fi_date = budget::local_day() + budget::months(base_months);
     contents.push_back({""s, ""s});
-    contents.push_back({"Months to FI"s, to_string(base_months)});
-    contents.push_back({"Years to FI"s, to_string(base_months / 12.0)});
-    contents.push_back({"Date to FI"s, to_string(fi_date)});
+    contents.push_back({"Months to FI"s, months_to_string(base_months)});
+    contents.push_back({"Years to FI"s, years_to_string(base_months)});
+    contents.push_back({"Date to FI"s, fi_date_to_string(base_months)});
 
     contents.push_back({""s, ""s});
     contents.push_back({"Current Withdrawal Rate"s, to_string(100.0 * (expenses / nw)) + "%"});
@@ -221,52 +469,93 @@ void budget::retirement_status(budget::writer& w) {
     contents.push_back({"Current Yearly Allowance"s, to_string(nw * (wrate / 100.0))});
     contents.push_back({"Current Monthly Allowance"s, to_string((nw * (wrate / 100.0)) / 12)});
 
-    auto a_fi_date = budget::local_day() + budget::months(a_base_months);
     contents.push_back({""s, ""s});
     contents.push_back({"Adjusted Savings Rate"s, to_string(100 * a_savings_rate) + "%"});
     contents.push_back({"Adjusted Yearly savings"s, to_string(a_savings_rate * income) + " " + currency});
-    contents.push_back({"Adjusted Months to FI"s, to_string(a_base_months)});
-    contents.push_back({"Adjusted Years to FI"s, to_string(a_base_months / 12.0)});
-    contents.push_back({"Adjusted Date to FI"s, to_string(a_fi_date)});
+    contents.push_back({"Adjusted Months to FI"s, months_to_string(a_base_months)});
+    contents.push_back({"Adjusted Years to FI"s, years_to_string(a_base_months)});
+    contents.push_back({"Adjusted Date to FI"s, fi_date_to_string(a_base_months)});
 
     w.display_table(columns, contents);
 
-    std::array<int, 5> rate_decs{1, 2, 5, 10, 20};
+    for (size_t i = 0; i < rate_decs.size(); ++i) {
+        auto months_dec = months[2 + i];
 
-    // Note: this not totally correct since we ignore the
-    // correlation between the savings rate and the expenses
+        w << p_begin << "Increasing Savings Rate by " << rate_decs[i] << "% would save " << saved_years_to_string(base_months, months_dec) << " years (in " << years_to_string(months_dec) << " years)" << p_end;
+    }
 
-    for (auto dec : rate_decs) {
-        auto dec_savings_rate = savings_rate + 0.01 * dec;
+    for (size_t i = 0; i < exp_decs.size(); ++i) {
+        auto months_dec = months[2 + rate_decs.size() + i];
 
-        auto current_nw = nw;
-        size_t months   = 0;
+        w << p_begin << "Decreasing monthly expenses by " << exp_decs[i] << " " << currency << " would save " << saved_years_to_string(base_months, months_dec) << " years (in " << years_to_string(months_dec) << " (adjusted) years)" << p_end;
+    }
+}
 
-        while (current_nw < years * expenses) {
-            current_nw *= 1.0 + (roi / 100.0) / 12;
-            current_nw += (dec_savings_rate * income) / 12;
+void budget::retirement_simulation(budget::writer& w) {
+    if (!internal_config_contains("withdrawal_rate") || !internal_config_contains("expected_roi")) {
+        w << "Not enough information, please configure first with retirement set" << end_of_line;
+        return;
+    }
 
-            ++months;
-        }
+    auto currency     = get_default_currency();
+    auto wrate        = to_number<double>(internal_config_value("withdrawal_rate"));
+    auto roi          = to_number<double>(internal_config_value("expected_roi"));
+    auto years        = double(int(100.0 / wrate));
+    auto expenses     = running_expenses();
+    auto savings_rate = running_savings_rate();
+    auto income       = 12 * get_base_income();
+
+    simulation_parameters params;
+    params.nw      = get_net_worth();
+    params.target  = years * expenses;
+    params.savings = savings_rate * income;
+    params.paths   = std::max(to_number<size_t>(config_value("retirement_simulation_paths", "20000")), size_t(1));
 
-        w << p_begin << "Increasing Savings Rate by " << dec << "% would save " << (base_months - months) / 12.0 << " years (in " << months / 12.0 << " years)" << p_end;
+    auto source = make_return_source(roi);
+
+    auto start     = std::chrono::steady_clock::now();
+    auto fi_months = simulate_paths(params, source);
+    auto end       = std::chrono::steady_clock::now();
+
+    auto duration = std::chrono::duration<double>(end - start).count();
+
+    std::vector<std::string> columns = {};
+    std::vector<std::vector<std::string>> contents;
+
+    using namespace std::string_literals;
+
+    if (source.bootstrap()) {
+        contents.push_back({"Returns"s, "Bootstrapped from " + to_string(source.returns.size()) + " years"});
+    } else {
+        contents.push_back({"Annual Return"s, to_string(roi) + "%"});
+        contents.push_back({"Annual Volatility"s, to_string(100.0 * source.volatility) + "%"});
     }
 
-    std::array<int, 5> exp_decs{10, 50, 100, 200, 500};
+    contents.push_back({"Target Net Worth"s, to_string(years * expenses) + " " + currency});
+    contents.push_back({"Yearly savings"s, to_string(savings_rate * income) + " " + currency});
+    contents.push_back({"Simulated paths"s, to_string(params.paths)});
 
-    for (auto dec : exp_decs) {
-        auto current_nw = nw;
-        size_t months   = 0;
+    contents.push_back({""s, ""s});
 
-        auto new_savings_rate = (income - (expenses - dec * 12)) / income;;
+    std::array<size_t, 5> percentiles{10, 25, 50, 75, 90};
 
-        while (current_nw < years * (expenses - (dec * 12))) {
-            current_nw *= 1.0 + (roi / 100.0) / 12;
-            current_nw += (new_savings_rate * income) / 12;
+    for (auto percentile : percentiles) {
+        auto months = fi_months[(percentile * (fi_months.size() - 1)) / 100];
+        contents.push_back({to_string(percentile) + "th percentile FI"s, fi_months_to_string(months)});
+    }
 
-            ++months;
-        }
+    contents.push_back({""s, ""s});
+
+    std::array<size_t, 5> horizons{10, 20, 30, 40, 50};
 
-        w << p_begin << "Decreasing monthly expenses by " << dec << " " << currency << " would save " << (base_months - months) / 12.0 << " years (in " << months / 12.0 << " (adjusted) years)" << p_end;
+    for (auto horizon : horizons) {
+        auto reached = std::upper_bound(fi_months.begin(), fi_months.end(), horizon * 12) - fi_months.begin();
+        contents.push_back({"FI within "s + to_string(horizon) + " years", to_string(100.0 * reached / fi_months.size()) + "%"});
     }
+
+    contents.push_back({""s, ""s});
+    contents.push_back({"Simulation time"s, to_string(1000.0 * duration) + "ms"});
+    contents.push_back({"Paths per second"s, to_string(size_t(params.paths / std::max(duration, 1e-9)))});
+
+    w.display_table(columns, contents);
 }
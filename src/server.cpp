@@ -6,7 +6,10 @@
 //=======================================================================
 
 #include <set>
+#include <map>
+#include <ctime>
 #include <thread>
+#include <iostream>
 
 #include "cpp_utils/assert.hpp"
 
@@ -25,6 +28,7 @@
 #include "server_api.hpp"
 #include "server_pages.hpp"
 #include "http.hpp"
+#include "loader.hpp"
 
 using namespace budget;
 
@@ -32,6 +36,14 @@ namespace {
 
 bool server_running = false;
 
+std::shared_timed_mutex data_lock;
+
+std::map<std::string, budget::module_endpoint*>& endpoints(){
+    // Function static to be safe from the order of the static initialization
+    static std::map<std::string, budget::module_endpoint*> endpoints;
+    return endpoints;
+}
+
 void start_server(){
     httplib::Server server;
 
@@ -53,20 +65,34 @@ void start_server(){
     server.listen(listen.c_str(), port);
 }
 
+void refresh_exchange_rates(){
+    budget::refresh_currency_cache();
+
+    auto stats = budget::currency_cache_statistics();
+
+    std::cout << "Refreshed the currency cache in " << stats.last_refresh_ms << "ms"
+              << " (hits: " << stats.hits << ", misses: " << stats.misses << ")" << std::endl;
+}
+
 void start_cron_loop(){
     size_t hours = 0;
 
+    // Make sure the persisted rates are up to date
+    refresh_exchange_rates();
+
     while(true){
         using namespace std::chrono_literals;
 
         std::this_thread::sleep_for(1h);
         ++hours;
 
-        check_for_recurrings();
+        {
+            auto lock = write_data_lock();
+            check_for_recurrings();
+        }
 
         if(hours % 6 == 0){
-            std::cout << "Invalidate the currency cache" << std::endl;
-            budget::invalidate_currency_cache();
+            refresh_exchange_rates();
         }
     }
 }
@@ -76,19 +102,17 @@ void start_cron_loop(){
 void budget::set_server_running(){
     // Indicates to the system that it's running in server mode
     server_running = true;
+
+    // Fix the identifier of this instance
+    server_epoch();
 }
 
 void budget::server_module::load(){
-    load_accounts();
-    load_expenses();
-    load_earnings();
-    load_assets();
-    load_objectives();
-    load_wishes();
-    load_fortunes();
-    load_recurrings();
-    load_debts();
-    load_wishes();
+    load_concurrently({
+        load_accounts, load_expenses, load_earnings, load_assets,
+        load_objectives, load_wishes, load_fortunes, load_recurrings,
+        load_debts
+    });
 }
 
 void budget::server_module::handle(const std::vector<std::string>& args){
@@ -106,3 +130,43 @@ void budget::server_module::handle(const std::vector<std::string>& args){
 bool budget::is_server_running(){
     return server_running;
 }
+
+budget::data_read_lock budget::read_data_lock(){
+    return data_read_lock(data_lock);
+}
+
+budget::data_write_lock budget::write_data_lock(){
+    return data_write_lock(data_lock);
+}
+
+const std::string& budget::server_epoch(){
+    static const std::string epoch = budget::to_string(std::time(nullptr));
+    return epoch;
+}
+
+void budget::register_module_endpoint(const std::string& module, module_endpoint* endpoint){
+    endpoints()[module] = endpoint;
+}
+
+bool budget::write_sync_changes(const std::string& module, const std::string& since, std::ostream& stream){
+    auto it = endpoints().find(module);
+
+    if (it == endpoints().end()) {
+        return false;
+    }
+
+    it->second->write_changes(stream, since);
+
+    return true;
+}
+
+bool budget::apply_mutations(const std::string& module, std::istream& records, std::ostream& result, std::string& error){
+    auto it = endpoints().find(module);
+
+    if (it == endpoints().end()) {
+        error = "Unknown module " + module;
+        return false;
+    }
+
+    return it->second->apply_mutations(records, result, error);
+}
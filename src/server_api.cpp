@@ -6,6 +6,8 @@
 //=======================================================================
 
 #include <set>
+#include <ostream>
+#include <streambuf>
 
 #include "cpp_utils/assert.hpp"
 
@@ -22,6 +24,7 @@
 #include "version.hpp"
 #include "wishes.hpp"
 #include "writer.hpp"
+#include "server.hpp"
 #include "server_api.hpp"
 #include "http.hpp"
 
@@ -100,6 +103,53 @@ void api_success_content(const httplib::Request& /*req*/, httplib::Response& res
     res.set_content(content, "text/plain");
 }
 
+/*!
+ * \brief Stream buffer appending directly to a string
+ */
+struct string_appender : std::streambuf {
+    explicit string_appender(std::string& target) : target(target) {}
+
+protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) {
+            target.push_back(traits_type::to_char_type(c));
+        }
+
+        return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        target.append(s, n);
+        return n;
+    }
+
+private:
+    std::string& target;
+};
+
+/*!
+ * \brief Write all the entries, one per line, directly into the body of
+ * the response, without any intermediate buffer.
+ *
+ * If the client gives the version of its replica (since parameter), only
+ * the changes since this version are sent.
+ */
+template <typename Data>
+void api_list_content(const httplib::Request& req, httplib::Response& res, const char* module, const Data& data) {
+    res.body.clear();
+
+    string_appender buffer(res.body);
+    std::ostream stream(&buffer);
+
+    if (!req.has_param("since") || !write_sync_changes(module, req.get_param_value("since"), stream)) {
+        for (auto& entry : data) {
+            stream << entry << '\n';
+        }
+    }
+
+    res.set_header("Content-Type", "text/plain");
+}
+
 void api_error(const httplib::Request& req, httplib::Response& res, const std::string& message) {
     if (req.has_param("server")) {
         auto url = req.get_param_value("back_page") + "?error=true&message=" + httplib::detail::encode_url(message);
@@ -109,6 +159,40 @@ void api_error(const httplib::Request& req, httplib::Response& res, const std::s
     }
 }
 
+/*!
+ * \brief Apply a batch of mutations, one per line of the body, in the
+ * journal format (+:<entry> to add or edit, -:<id> to delete). The id of
+ * the entry of each mutation is returned on its own line.
+ */
+void api_mutations(const httplib::Request& req, httplib::Response& res, const char* module) {
+    if (!api_start(req, res)) {
+        return;
+    }
+
+    std::stringstream records(req.body);
+    std::stringstream result;
+    std::string error;
+
+    if (!apply_mutations(module, records, result, error)) {
+        api_error(req, res, error);
+        return;
+    }
+
+    api_success_content(req, res, result.str());
+}
+
+void mutations_expenses_api(const httplib::Request& req, httplib::Response& res) {
+    api_mutations(req, res, "expenses");
+}
+
+void mutations_earnings_api(const httplib::Request& req, httplib::Response& res) {
+    api_mutations(req, res, "earnings");
+}
+
+void mutations_asset_values_api(const httplib::Request& req, httplib::Response& res) {
+    api_mutations(req, res, "asset_values");
+}
+
 bool parameters_present(const httplib::Request& req, std::vector<const char*> parameters) {
     for (auto& param : parameters) {
         if (!req.has_param(param)) {
@@ -197,7 +281,7 @@ void edit_accounts_api(const httplib::Request& req, httplib::Response& res) {
     account.name     = req.get_param_value("input_name");
     account.amount   = budget::parse_money(req.get_param_value("input_amount"));
 
-    set_accounts_changed();
+    edit_account(account);
 
     api_success(req, res, "Account " + to_string(account.id) + " has been modified");
 }
@@ -229,14 +313,7 @@ void list_accounts_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& account : all_accounts()) {
-        ss << account;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list_content(req, res, "accounts", all_accounts());
 }
 
 void archive_accounts_month_api(const httplib::Request& req, httplib::Response& res) {
@@ -304,7 +381,7 @@ void edit_expenses_api(const httplib::Request& req, httplib::Response& res) {
     expense.name     = req.get_param_value("input_name");
     expense.amount   = budget::parse_money(req.get_param_value("input_amount"));
 
-    set_expenses_changed();
+    edit_expense(expense);
 
     api_success(req, res, "Expense " + to_string(expense.id) + " has been modified");
 }
@@ -336,14 +413,7 @@ void list_expenses_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& expense : all_expenses()) {
-        ss << expense;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list_content(req, res, "expenses", all_expenses());
 }
 
 void add_earnings_api(const httplib::Request& req, httplib::Response& res) {
@@ -391,7 +461,7 @@ void edit_earnings_api(const httplib::Request& req, httplib::Response& res) {
     earning.name     = req.get_param_value("input_name");
     earning.amount   = budget::parse_money(req.get_param_value("input_amount"));
 
-    set_earnings_changed();
+    edit_earning(earning);
 
     api_success(req, res, "Earning " + to_string(earning.id) + " has been modified");
 }
@@ -423,14 +493,7 @@ void list_earnings_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& earning : all_earnings()) {
-        ss << earning;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list_content(req, res, "earnings", all_earnings());
 }
 
 void retirement_configure_api(const httplib::Request& req, httplib::Response& res) {
@@ -447,6 +510,10 @@ void retirement_configure_api(const httplib::Request& req, httplib::Response& re
     internal_config_value("withdrawal_rate") = req.get_param_value("input_wrate");
     internal_config_value("expected_roi") = req.get_param_value("input_roi");
 
+    if (req.has_param("input_volatility")) {
+        internal_config_value("return_volatility") = req.get_param_value("input_volatility");
+    }
+
     save_config();
 
     api_success(req, res, "Retirement configuration was saved");
@@ -500,7 +567,7 @@ void edit_objectives_api(const httplib::Request& req, httplib::Response& res) {
     objective.op         = req.get_param_value("input_operator");
     objective.amount     = budget::parse_money(req.get_param_value("input_amount"));
 
-    set_objectives_changed();
+    edit_objective(objective);
 
     api_success(req, res, "objective " + to_string(objective.id) + " has been modified");
 }
@@ -532,14 +599,7 @@ void list_objectives_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& objective : all_objectives()) {
-        ss << objective;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list_content(req, res, "objectives", all_objectives());
 }
 
 void add_assets_api(const httplib::Request& req, httplib::Response& res) {
@@ -605,7 +665,7 @@ void edit_assets_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    set_assets_changed();
+    edit_asset(asset);
 
     api_success(req, res, "asset " + to_string(asset.id) + " has been modified");
 }
@@ -637,14 +697,7 @@ void list_assets_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& asset : all_assets()) {
-        ss << asset;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list_content(req, res, "assets", all_assets());
 }
 
 void add_asset_values_api(const httplib::Request& req, httplib::Response& res) {
@@ -690,7 +743,7 @@ void edit_asset_values_api(const httplib::Request& req, httplib::Response& res)
     asset_value.asset_id     = budget::to_number<size_t>(req.get_param_value("input_asset"));
     asset_value.set_date     = budget::from_string(req.get_param_value("input_date"));
 
-    set_asset_values_changed();
+    edit_asset_value(asset_value);
 
     api_success(req, res, "Asset " + to_string(asset_value.id) + " has been modified");
 }
@@ -722,14 +775,7 @@ void list_asset_values_api(const httplib::Request& req, httplib::Response& res)
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& asset_value : all_asset_values()) {
-        ss << asset_value;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list_content(req, res, "asset_values", all_asset_values());
 }
 
 void batch_asset_values_api(const httplib::Request& req, httplib::Response& res) {
@@ -739,6 +785,8 @@ void batch_asset_values_api(const httplib::Request& req, httplib::Response& res)
 
     auto sorted_asset_values = all_sorted_asset_values();
 
+    begin_asset_values_batch();
+
     for (auto& asset : all_assets()) {
         auto input_name = "input_amount_" + budget::to_string(asset.id);
 
@@ -766,6 +814,8 @@ void batch_asset_values_api(const httplib::Request& req, httplib::Response& res)
         }
     }
 
+    commit_asset_values_batch();
+
     api_success(req, res, "Asset values have been updated");
 }
 
@@ -813,7 +863,7 @@ void edit_recurrings_api(const httplib::Request& req, httplib::Response& res) {
     recurring.name       = req.get_param_value("input_name");
     recurring.amount     = budget::parse_money(req.get_param_value("input_amount"));
 
-    set_recurrings_changed();
+    edit_recurring(recurring);
 
     api_success(req, res, "Recurring " + to_string(recurring.id) + " has been modified");
 }
@@ -845,14 +895,7 @@ void list_recurrings_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& recurring : all_recurrings()) {
-        ss << recurring;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list_content(req, res, "recurrings", all_recurrings());
 }
 
 void add_debts_api(const httplib::Request& req, httplib::Response& res) {
@@ -903,7 +946,7 @@ void edit_debts_api(const httplib::Request& req, httplib::Response& res) {
     debt.amount    = budget::parse_money(req.get_param_value("input_amount"));
     debt.state     = req.get_param_value("input_paid") == "yes" ? 1 : 0;
 
-    set_debts_changed();
+    edit_debt(debt);
 
     api_success(req, res, "Debt " + to_string(debt.id) + " has been modified");
 }
@@ -935,14 +978,7 @@ void list_debts_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& debt : all_debts()) {
-        ss << debt;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list_content(req, res, "debts", all_debts());
 }
 
 void add_fortunes_api(const httplib::Request& req, httplib::Response& res) {
@@ -986,7 +1022,7 @@ void edit_fortunes_api(const httplib::Request& req, httplib::Response& res) {
     fortune.check_date = budget::from_string(req.get_param_value("input_date"));
     fortune.amount     = budget::parse_money(req.get_param_value("input_amount"));
 
-    set_fortunes_changed();
+    edit_fortune(fortune);
 
     api_success(req, res, "Fortune " + to_string(fortune.id) + " has been modified");
 }
@@ -1018,14 +1054,7 @@ void list_fortunes_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& fortune : all_fortunes()) {
-        ss << fortune;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list_content(req, res, "fortunes", all_fortunes());
 }
 
 void add_wishes_api(const httplib::Request& req, httplib::Response& res) {
@@ -1083,7 +1112,7 @@ void edit_wishes_api(const httplib::Request& req, httplib::Response& res) {
         wish.paid_amount = budget::parse_money(req.get_param_value("input_paid_amount"));
     }
 
-    set_wishes_changed();
+    edit_wish(wish);
 
     api_success(req, res, "wish " + to_string(wish.id) + " has been modified");
 }
@@ -1115,14 +1144,7 @@ void list_wishes_api(const httplib::Request& req, httplib::Response& res) {
         return;
     }
 
-    std::stringstream ss;
-
-    for (auto& wish : all_wishes()) {
-        ss << wish;
-        ss << std::endl;
-    }
-
-    api_success_content(req, res, ss.str());
+    api_list_content(req, res, "wishes", all_wishes());
 }
 
 } //end of anonymous namespace
@@ -1132,58 +1154,61 @@ void budget::load_api(httplib::Server& server) {
     server.get("/api/server/version/", &server_version_api);
     server.post("/api/server/version/support/", &server_version_support_api);
 
-    server.post("/api/accounts/add/", &add_accounts_api);
-    server.post("/api/accounts/edit/", &edit_accounts_api);
-    server.post("/api/accounts/delete/", &delete_accounts_api);
-    server.post("/api/accounts/archive/month/", &archive_accounts_month_api);
-    server.post("/api/accounts/archive/year/", &archive_accounts_year_api);
-    server.get("/api/accounts/list/", &list_accounts_api);
-
-    server.post("/api/expenses/add/", &add_expenses_api);
-    server.post("/api/expenses/edit/", &edit_expenses_api);
-    server.post("/api/expenses/delete/", &delete_expenses_api);
-    server.get("/api/expenses/list/", &list_expenses_api);
-
-    server.post("/api/earnings/add/", &add_earnings_api);
-    server.post("/api/earnings/edit/", &edit_earnings_api);
-    server.post("/api/earnings/delete/", &delete_earnings_api);
-    server.get("/api/earnings/list/", &list_earnings_api);
-
-    server.post("/api/recurrings/add/", &add_recurrings_api);
-    server.post("/api/recurrings/edit/", &edit_recurrings_api);
-    server.post("/api/recurrings/delete/", &delete_recurrings_api);
-    server.get("/api/recurrings/list/", &list_recurrings_api);
-
-    server.post("/api/debts/add/", &add_debts_api);
-    server.post("/api/debts/edit/", &edit_debts_api);
-    server.post("/api/debts/delete/", &delete_debts_api);
-    server.get("/api/debts/list/", &list_debts_api);
-
-    server.post("/api/fortunes/add/", &add_fortunes_api);
-    server.post("/api/fortunes/edit/", &edit_fortunes_api);
-    server.post("/api/fortunes/delete/", &delete_fortunes_api);
-    server.get("/api/fortunes/list/", &list_fortunes_api);
-
-    server.post("/api/wishes/add/", &add_wishes_api);
-    server.post("/api/wishes/edit/", &edit_wishes_api);
-    server.post("/api/wishes/delete/", &delete_wishes_api);
-    server.get("/api/wishes/list/", &list_wishes_api);
-
-    server.post("/api/assets/add/", &add_assets_api);
-    server.post("/api/assets/edit/", &edit_assets_api);
-    server.post("/api/assets/delete/", &delete_assets_api);
-    server.get("/api/assets/list/", &list_assets_api);
-
-    server.post("/api/asset_values/add/", &add_asset_values_api);
-    server.post("/api/asset_values/edit/", &edit_asset_values_api);
-    server.post("/api/asset_values/batch/", &batch_asset_values_api);
-    server.post("/api/asset_values/delete/", &delete_asset_values_api);
-    server.get("/api/asset_values/list/", &list_asset_values_api);
-
-    server.post("/api/retirement/configure/", &retirement_configure_api);
-
-    server.post("/api/objectives/add/", &add_objectives_api);
-    server.post("/api/objectives/edit/", &edit_objectives_api);
-    server.post("/api/objectives/delete/", &delete_objectives_api);
-    server.get("/api/objectives/list/", &list_objectives_api);
+    server.post("/api/accounts/add/", write_locked(&add_accounts_api));
+    server.post("/api/accounts/edit/", write_locked(&edit_accounts_api));
+    server.post("/api/accounts/delete/", write_locked(&delete_accounts_api));
+    server.post("/api/accounts/archive/month/", write_locked(&archive_accounts_month_api));
+    server.post("/api/accounts/archive/year/", write_locked(&archive_accounts_year_api));
+    server.get("/api/accounts/list/", read_locked(&list_accounts_api));
+
+    server.post("/api/expenses/add/", write_locked(&add_expenses_api));
+    server.post("/api/expenses/edit/", write_locked(&edit_expenses_api));
+    server.post("/api/expenses/delete/", write_locked(&delete_expenses_api));
+    server.post("/api/expenses/mutations/", write_locked(&mutations_expenses_api));
+    server.get("/api/expenses/list/", read_locked(&list_expenses_api));
+
+    server.post("/api/earnings/add/", write_locked(&add_earnings_api));
+    server.post("/api/earnings/edit/", write_locked(&edit_earnings_api));
+    server.post("/api/earnings/delete/", write_locked(&delete_earnings_api));
+    server.post("/api/earnings/mutations/", write_locked(&mutations_earnings_api));
+    server.get("/api/earnings/list/", read_locked(&list_earnings_api));
+
+    server.post("/api/recurrings/add/", write_locked(&add_recurrings_api));
+    server.post("/api/recurrings/edit/", write_locked(&edit_recurrings_api));
+    server.post("/api/recurrings/delete/", write_locked(&delete_recurrings_api));
+    server.get("/api/recurrings/list/", read_locked(&list_recurrings_api));
+
+    server.post("/api/debts/add/", write_locked(&add_debts_api));
+    server.post("/api/debts/edit/", write_locked(&edit_debts_api));
+    server.post("/api/debts/delete/", write_locked(&delete_debts_api));
+    server.get("/api/debts/list/", read_locked(&list_debts_api));
+
+    server.post("/api/fortunes/add/", write_locked(&add_fortunes_api));
+    server.post("/api/fortunes/edit/", write_locked(&edit_fortunes_api));
+    server.post("/api/fortunes/delete/", write_locked(&delete_fortunes_api));
+    server.get("/api/fortunes/list/", read_locked(&list_fortunes_api));
+
+    server.post("/api/wishes/add/", write_locked(&add_wishes_api));
+    server.post("/api/wishes/edit/", write_locked(&edit_wishes_api));
+    server.post("/api/wishes/delete/", write_locked(&delete_wishes_api));
+    server.get("/api/wishes/list/", read_locked(&list_wishes_api));
+
+    server.post("/api/assets/add/", write_locked(&add_assets_api));
+    server.post("/api/assets/edit/", write_locked(&edit_assets_api));
+    server.post("/api/assets/delete/", write_locked(&delete_assets_api));
+    server.get("/api/assets/list/", read_locked(&list_assets_api));
+
+    server.post("/api/asset_values/add/", write_locked(&add_asset_values_api));
+    server.post("/api/asset_values/edit/", write_locked(&edit_asset_values_api));
+    server.post("/api/asset_values/batch/", write_locked(&batch_asset_values_api));
+    server.post("/api/asset_values/delete/", write_locked(&delete_asset_values_api));
+    server.post("/api/asset_values/mutations/", write_locked(&mutations_asset_values_api));
+    server.get("/api/asset_values/list/", read_locked(&list_asset_values_api));
+
+    server.post("/api/retirement/configure/", write_locked(&retirement_configure_api));
+
+    server.post("/api/objectives/add/", write_locked(&add_objectives_api));
+    server.post("/api/objectives/edit/", write_locked(&edit_objectives_api));
+    server.post("/api/objectives/delete/", write_locked(&delete_objectives_api));
+    server.get("/api/objectives/list/", read_locked(&list_objectives_api));
 }
@@ -7,6 +7,8 @@
 
 #include <set>
 #include <numeric>
+#include <mutex>
+#include <unordered_map>
 
 #include "cpp_utils/assert.hpp"
 
@@ -26,6 +28,7 @@
 #include "retirement.hpp"
 #include "writer.hpp"
 #include "currency.hpp"
+#include "server.hpp"
 
 #include "server_pages.hpp"
 #include "http.hpp"
@@ -284,6 +287,7 @@ std::string header(const std::string& title, bool menu = true) {
                   <a class="dropdown-item" href="/retirement/status/">Status</a>
                   <a class="dropdown-item" href="/retirement/configure/">Configure</a>
                   <a class="dropdown-item" href="/retirement/fi/">FI Ratio Over Time</a>
+                  <a class="dropdown-item" href="/retirement/simulation/">Simulation</a>
                 </div>
               </li>
         )=====";
@@ -326,6 +330,7 @@ std::string header(const std::string& title, bool menu = true) {
                   <a class="dropdown-item" href="/wishes/status/">Status</a>
                   <a class="dropdown-item" href="/wishes/list/">List</a>
                   <a class="dropdown-item" href="/wishes/estimate/">Estimate</a>
+                  <a class="dropdown-item" href="/wishes/plan/">Plan</a>
                   <a class="dropdown-item" href="/wishes/add/">Add Wish</a>
                 </div>
               </li>
@@ -379,19 +384,43 @@ void display_message(budget::writer& w, const httplib::Request& req) {
     }
 }
 
+/*!
+ * \brief Replace the placeholders of the html into the given output, in a
+ * single pass. The large list pages contain a placeholder on each row.
+ */
+void filter_html(const std::string& html, const httplib::Request& req, std::string& output) {
+    static const std::string this_page = "__budget_this_page__";
+    static const std::string currency  = "__currency__";
 
-void replace_all(std::string& source, const std::string& from, const std::string& to) {
-    size_t current_pos = 0;
+    auto default_currency = get_default_currency();
 
-    while ((current_pos = source.find(from, current_pos)) != std::string::npos) {
-        source.replace(current_pos, from.length(), to);
-        current_pos += to.length();
+    output.clear();
+    output.reserve(html.size());
+
+    size_t current = 0;
+
+    while (true) {
+        auto next = html.find("__", current);
+
+        if (next == std::string::npos) {
+            break;
+        }
+
+        if (html.compare(next, this_page.size(), this_page) == 0) {
+            output.append(html, current, next - current);
+            output += req.path;
+            current = next + this_page.size();
+        } else if (html.compare(next, currency.size(), currency) == 0) {
+            output.append(html, current, next - current);
+            output += default_currency;
+            current = next + currency.size();
+        } else {
+            output.append(html, current, next + 1 - current);
+            current = next + 1;
+        }
     }
-}
 
-void filter_html(std::string& html, const httplib::Request& req) {
-    replace_all(html, "__budget_this_page__", req.path);
-    replace_all(html, "__currency__", get_default_currency());
+    output.append(html, current, std::string::npos);
 }
 
 //Note: This must be synchronized with page_end
@@ -399,6 +428,203 @@ std::string footer() {
     return "</main></body></html>";
 }
 
+void unauthorized(httplib::Response& res) {
+    res.status = 401;
+    res.set_header("WWW-Authenticate", "Basic realm=\"budgetwarrior\"");
+}
+
+bool authenticate(const httplib::Request& req, httplib::Response& res) {
+    if (!is_secure()) {
+        return true;
+    }
+
+    if (!req.has_header("Authorization")) {
+        unauthorized(res);
+        return false;
+    }
+
+    auto authorization = req.get_header_value("Authorization");
+
+    if (authorization.substr(0, 6) != "Basic ") {
+        unauthorized(res);
+        return false;
+    }
+
+    auto sub_authorization = authorization.substr(6, authorization.size());
+    auto decoded           = base64_decode(sub_authorization);
+
+    if (decoded.find(':') == std::string::npos) {
+        unauthorized(res);
+        return false;
+    }
+
+    auto username = decoded.substr(0, decoded.find(':'));
+    auto password = decoded.substr(decoded.find(':') + 1, decoded.size());
+
+    if (username != get_web_user() || password != get_web_password()) {
+        unauthorized(res);
+        return false;
+    }
+
+    return true;
+}
+
+// The generations of the data a cached page is rendered from
+
+using generation_function = size_t (*)();
+using page_dependencies   = std::vector<generation_function>;
+
+const page_dependencies budget_data {&accounts_generation, &expenses_generation, &earnings_generation};
+const page_dependencies assets_data {&assets_generation, &asset_values_generation, &currency_cache_generation};
+const page_dependencies fortunes_data {&fortunes_generation};
+
+const page_dependencies all_data {
+    &accounts_generation, &expenses_generation, &earnings_generation,
+    &assets_generation, &asset_values_generation, &currency_cache_generation,
+    &objectives_generation, &wishes_generation, &fortunes_generation,
+    &recurrings_generation, &debts_generation};
+
+constexpr const size_t max_cached_pages = 256;
+
+struct cached_page {
+    std::vector<size_t> generations;
+    std::string content;
+    std::string etag;
+};
+
+/*!
+ * \brief Cache of the rendered pages, by route and query parameters.
+ *
+ * A cached page is only valid as long as the generations of the modules
+ * it is rendered from (and the current day) did not change.
+ */
+struct page_cache {
+    bool get(const std::string& key, const std::vector<size_t>& generations, cached_page& page) {
+        std::lock_guard<std::mutex> l(lock);
+
+        auto it = pages.find(key);
+
+        if (it == pages.end() || it->second.generations != generations) {
+            return false;
+        }
+
+        page = it->second;
+
+        return true;
+    }
+
+    void put(const std::string& key, cached_page page) {
+        std::lock_guard<std::mutex> l(lock);
+
+        // The stale pages are only dropped once the cache is full
+        if (pages.size() >= max_cached_pages && !pages.count(key)) {
+            pages.clear();
+        }
+
+        pages[key] = std::move(page);
+    }
+
+private:
+    std::mutex lock;
+    std::unordered_map<std::string, cached_page> pages;
+};
+
+page_cache rendered_pages;
+
+std::string page_key(const httplib::Request& req) {
+    std::string key = req.path;
+
+    // The parameters are stored sorted by name
+    for (auto& param : req.params) {
+        key += '&';
+        key += param.first;
+        key += '=';
+        key += param.second;
+    }
+
+    return key;
+}
+
+std::vector<size_t> page_generations(const page_dependencies& dependencies) {
+    std::vector<size_t> generations;
+    generations.reserve(dependencies.size() + 1);
+
+    for (auto& generation : dependencies) {
+        generations.push_back(generation());
+    }
+
+    // Most of the pages are relative to the current date
+    auto today = budget::local_day();
+    generations.push_back(today.year() * 10000 + today.month() * 100 + today.day());
+
+    return generations;
+}
+
+bool etag_matches(const httplib::Request& req, const std::string& etag) {
+    if (!req.has_header("If-None-Match")) {
+        return false;
+    }
+
+    auto value = req.get_header_value("If-None-Match");
+
+    return value == "*" || value.find(etag) != std::string::npos;
+}
+
+void send_cached_page(const httplib::Request& req, httplib::Response& res, const cached_page& page) {
+    res.set_header("ETag", page.etag);
+    res.set_header("Cache-Control", "no-cache");
+
+    if (etag_matches(req, page.etag)) {
+        res.status = 304;
+    } else {
+        res.set_content(page.content, "text/html");
+    }
+}
+
+/*!
+ * \brief Wrap a page handler so that the rendered page is served from memory
+ * until the data it depends on changes.
+ */
+httplib::Server::Handler cached(void (*handler)(const httplib::Request&, httplib::Response&), const page_dependencies& dependencies) {
+    return [handler, &dependencies](const httplib::Request& req, httplib::Response& res) {
+        // The authentication is never cached
+        if (!authenticate(req, res)) {
+            return;
+        }
+
+        auto lock = read_data_lock();
+
+        auto key         = page_key(req);
+        auto generations = page_generations(dependencies);
+
+        cached_page page;
+
+        if (rendered_pages.get(key, generations, page)) {
+            send_cached_page(req, res, page);
+            return;
+        }
+
+        handler(req, res);
+
+        // Only the complete pages are cached
+        if ((res.status != -1 && res.status != 200) || res.body.empty()) {
+            return;
+        }
+
+        std::stringstream etag;
+        etag << '"' << std::hex << std::hash<std::string>()(res.body) << '"';
+
+        page.generations = std::move(generations);
+        page.content     = res.body;
+        page.etag        = etag.str();
+
+        res.set_header("ETag", page.etag);
+        res.set_header("Cache-Control", "no-cache");
+
+        rendered_pages.put(key, std::move(page));
+    };
+}
+
 std::stringstream start_chart_base(budget::html_writer& w, const std::string& chart_type, const std::string& id = "container", std::string style = "") {
     w.use_module("highcharts");
 
@@ -446,6 +672,37 @@ void end_chart(budget::html_writer& w, std::stringstream& ss) {
     w.defer_script(ss.str());
 }
 
+void add_chart_point(std::stringstream& ss, budget::date date, budget::money value) {
+    ss << "[Date.UTC(" << date.year() << "," << date.month().value - 1 << "," << date.day() << ") ," << budget::to_flat_string(value) << "],";
+}
+
+void add_asset_serie(std::stringstream& ss, const budget::asset_series& series, size_t serie) {
+    for (size_t i = 0; i < series.dates.size(); ++i) {
+        add_chart_point(ss, series.dates[i], series.values[serie][i]);
+    }
+}
+
+budget::money last_asset_value(const budget::asset_series& series, size_t serie) {
+    return series.dates.empty() ? budget::money() : series.values[serie].back();
+}
+
+/*!
+ * \brief Weight of an asset in an asset class (int. stocks, dom. stocks,
+ * bonds or cash)
+ */
+float asset_class_weight(const budget::asset& asset, size_t asset_class) {
+    switch (asset_class) {
+        case 0:
+            return float(asset.int_stocks) / 100.0f;
+        case 1:
+            return float(asset.dom_stocks) / 100.0f;
+        case 2:
+            return float(asset.bonds) / 100.0f;
+        default:
+            return float(asset.cash) / 100.0f;
+    }
+}
+
 void add_date_picker(budget::writer& w, const std::string& default_value = "", bool one_line = false) {
     if (one_line) {
         w << R"=====(<div class="form-group row">)=====";
@@ -1009,29 +1266,8 @@ void net_worth_graph(budget::html_writer& w, const std::string style = "", bool
     ss << "{ name: 'Net Worth',";
     ss << "data: [";
 
-    std::map<size_t, budget::money> asset_amounts;
-
-    auto sorted_asset_values = all_sorted_asset_values();
-
-    auto it  = sorted_asset_values.begin();
-    auto end = sorted_asset_values.end();
-
-    while (it != end) {
-        auto date = it->set_date;
-
-        while (it->set_date == date) {
-            asset_amounts[it->asset_id] = it->amount * exchange_rate(get_asset(it->asset_id).currency);
-
-            ++it;
-        }
-
-        budget::money sum;
-
-        for (auto& asset : asset_amounts) {
-            sum += asset.second;
-        }
-
-        ss << "[Date.UTC(" << date.year() << "," << date.month().value - 1 << "," << date.day() << ") ," << budget::to_flat_string(sum) << "],";
+    for (auto& point : *net_worth_timeline()) {
+        add_chart_point(ss, point.date, point.net_worth);
     }
 
     ss << "]},";
@@ -1106,6 +1342,8 @@ void objectives_card(budget::html_writer& w){
 
     w << R"=====(<div class="row card-body">)=====";
 
+    auto compiled = budget::compiled_objectives();
+
     for (size_t i = 0; i < objectives.size(); ++i) {
         auto& objective = objectives[i];
 
@@ -1124,12 +1362,12 @@ void objectives_card(budget::html_writer& w){
         std::string success;
         int success_int;
 
-        if (objective.type == "yearly") {
-            status      = budget::get_status(year_status, objective);
-            success_int = budget::compute_success(year_status, objective);
-        } else if (objective.type == "monthly") {
-            status      = budget::get_status(month_status, objective);
-            success_int = budget::compute_success(month_status, objective);
+        if (compiled[i].period == budget::objective_period::yearly) {
+            status      = budget::get_status(year_status, compiled[i]);
+            success_int = compiled[i].success(year_status);
+        } else if (compiled[i].period == budget::objective_period::monthly) {
+            status      = budget::get_status(month_status, compiled[i]);
+            success_int = compiled[i].success(month_status);
         } else {
             cpp_unreachable("Invalid objective type");
         }
@@ -1652,36 +1890,22 @@ void time_graph_expenses_page(const httplib::Request& req, httplib::Response& re
     std::vector<budget::money> serie;
     std::vector<std::string> dates;
 
-    auto sy = start_year();
-
-    for(unsigned short j = sy; j <= budget::local_day().year(); ++j){
-        budget::year year = j;
-
-        auto sm = start_month(year);
-        auto last = 13;
-
-        if(year == budget::local_day().year()){
-            last = budget::local_day().month() + 1;
-        }
+    auto sy    = start_year();
+    auto first = budget::date(sy, start_month(sy), 1);
 
-        for(unsigned short i = sm; i < last; ++i){
-            budget::month month = i;
+    auto date = first;
 
-            budget::money sum;
+    for(auto& status : compute_monthly_statuses(first, budget::local_day())){
+        auto sum = status.expenses;
 
-            for(auto& expense : all_expenses()){
-                if(expense.date.year() == year && expense.date.month() == month){
-                    sum += expense.amount;
-                }
-            }
+        std::string label = "Date.UTC(" + std::to_string(date.year()) + "," + std::to_string(date.month() - 1) + ", 1)";
 
-            std::string date = "Date.UTC(" + std::to_string(year) + "," + std::to_string(month.value - 1) + ", 1)";
+        serie.push_back(sum);
+        dates.push_back(label);
 
-            serie.push_back(sum);
-            dates.push_back(date);
+        ss << "[" << label <<  "," << budget::to_flat_string(sum) << "],";
 
-            ss << "[" << date <<  "," << budget::to_flat_string(sum) << "],";
-        }
+        date += budget::months(1);
     }
 
     ss << "]},";
@@ -1897,53 +2121,28 @@ void time_graph_savings_rate_page(const httplib::Request& req, httplib::Response
     std::vector<float> serie;
     std::vector<std::string> dates;
 
-    auto sy = start_year();
-
-    for(unsigned short j = sy; j <= budget::local_day().year(); ++j){
-        budget::year year = j;
-
-        auto sm = start_month(year);
-        auto last = 13;
-
-        if(year == budget::local_day().year()){
-            last = budget::local_day().month() + 1;
-        }
+    auto sy    = start_year();
+    auto first = budget::date(sy, start_month(sy), 1);
 
-        for(unsigned short i = sm; i < last; ++i){
-            budget::month month = i;
+    auto date = first;
 
-            budget::money income;
-            budget::money expenses;
+    for(auto& status : compute_monthly_statuses(first, budget::local_day())){
+        auto income = status.budget + status.earnings;
 
-            for(auto& account : all_accounts(year, month)){
-                income += account.amount;
-            }
+        auto savings_rate = (income - status.expenses) / income;
 
-            for(auto& earning : all_earnings()){
-                if(earning.date.year() == year && earning.date.month() == month){
-                    income += earning.amount;
-                }
-            }
-
-            for(auto& expense : all_expenses()){
-                if(expense.date.year() == year && expense.date.month() == month){
-                    expenses += expense.amount;
-                }
-            }
-
-            auto savings_rate = (income - expenses) / income;
+        if(savings_rate < 0){
+            savings_rate = 0;
+        }
 
-            if(savings_rate < 0){
-                savings_rate = 0;
-            }
+        std::string label = "Date.UTC(" + std::to_string(date.year()) + "," + std::to_string(date.month() - 1) + ", 1)";
 
-            std::string date = "Date.UTC(" + std::to_string(year) + "," + std::to_string(month.value - 1) + ", 1)";
+        serie.push_back(savings_rate);
+        dates.push_back(label);
 
-            serie.push_back(savings_rate);
-            dates.push_back(date);
+        ss << "[" << label << " ," << 100.0 * savings_rate << "],";
 
-            ss << "[" << date << " ," << 100.0 * savings_rate << "],";
-        }
+        date += budget::months(1);
     }
 
     ss << "]},";
@@ -1985,9 +2184,7 @@ void retirement_fi_ratio_over_time(const httplib::Request& req, httplib::Respons
 
     budget::html_writer w(content_stream);
 
-    auto values = all_sorted_asset_values();
-
-    if (!values.empty()){
+    if (!budget::net_worth_timeline()->empty()){
 
         auto ss = start_chart(w, "FI Ratio over time", "line", "fi_time_graph", "");
 
@@ -2000,23 +2197,9 @@ void retirement_fi_ratio_over_time(const httplib::Request& req, httplib::Respons
         ss << "{ name: 'FI Ratio %',";
         ss << "data: [";
 
-        std::vector<budget::money> serie;
-        std::vector<std::string> dates;
-
-        auto previous = values.front().set_date;
-
-        for (size_t i = 0; i < values.size(); ++i) {
-            auto& asset_value = values[i];
-            auto current = asset_value.set_date;
-
-            if (i == 0 || !(previous.month() == current.month() && previous.year() == current.year())) {
-                previous = current;
-
-                auto ratio = budget::fi_ratio(previous);
-
-                std::string date = "Date.UTC(" + std::to_string(previous.year()) + "," + std::to_string(previous.month().value - 1) + ", 1)";
-                ss << "[" << date <<  "," << budget::to_string(100 * ratio) << "],";
-            }
+        for (auto& point : budget::fi_ratio_timeline()) {
+            std::string date = "Date.UTC(" + std::to_string(point.date.year()) + "," + std::to_string(point.date.month().value - 1) + ", 1)";
+            ss << "[" << date <<  "," << budget::to_string(100 * point.ratio) << "],";
         }
 
         ss << "]},";
@@ -2050,40 +2233,22 @@ void time_graph_income_page(const httplib::Request& req, httplib::Response& res)
     std::vector<budget::money> serie;
     std::vector<std::string> dates;
 
-    auto sy = start_year();
+    auto sy    = start_year();
+    auto first = budget::date(sy, start_month(sy), 1);
 
-    for(unsigned short j = sy; j <= budget::local_day().year(); ++j){
-        budget::year year = j;
+    auto date = first;
 
-        auto sm = start_month(year);
-        auto last = 13;
+    for(auto& status : compute_monthly_statuses(first, budget::local_day())){
+        auto sum = status.budget + status.earnings;
 
-        if(year == budget::local_day().year()){
-            last = budget::local_day().month() + 1;
-        }
-
-        for(unsigned short i = sm; i < last; ++i){
-            budget::month month = i;
+        std::string label = "Date.UTC(" + std::to_string(date.year()) + "," + std::to_string(date.month() - 1) + ", 1)";
 
-            budget::money sum;
+        serie.push_back(sum);
+        dates.push_back(label);
 
-            for(auto& account : all_accounts(year, month)){
-                sum += account.amount;
-            }
+        ss << "[" << label <<  "," << budget::to_flat_string(sum) << "],";
 
-            for(auto& earning : all_earnings()){
-                if(earning.date.year() == year && earning.date.month() == month){
-                    sum += earning.amount;
-                }
-            }
-
-            std::string date = "Date.UTC(" + std::to_string(year) + "," + std::to_string(month.value - 1) + ", 1)";
-
-            serie.push_back(sum);
-            dates.push_back(date);
-
-            ss << "[" << date <<  "," << budget::to_flat_string(sum) << "],";
-        }
+        date += budget::months(1);
     }
 
     ss << "]},";
@@ -2315,38 +2480,17 @@ void portfolio_currency_page(const httplib::Request& req, httplib::Response& res
 
     ss << "series: [";
 
-    auto sorted_asset_values = all_sorted_asset_values();
-
-    for (auto& currency : currencies) {
-        ss << "{ name: '" << currency << "',";
-        ss << "data: [";
-
-        std::map<size_t, budget::money> asset_amounts;
-
-        auto it  = sorted_asset_values.begin();
-        auto end = sorted_asset_values.end();
-
-        while (it != end) {
-            auto date = it->set_date;
-
-            while (it->set_date == date) {
-                auto& asset = get_asset(it->asset_id);
+    std::vector<std::string> serie_currencies(currencies.begin(), currencies.end());
 
-                if (asset.currency == currency && asset.portfolio) {
-                    asset_amounts[it->asset_id] = it->amount * exchange_rate(asset.currency);
-                }
-
-                ++it;
-            }
-
-            budget::money sum;
+    auto series = compute_asset_series(serie_currencies.size(), [&serie_currencies](const budget::asset& asset, size_t serie) {
+        return asset.portfolio && asset.currency == serie_currencies[serie] ? 1.0f : 0.0f;
+    });
 
-            for (auto& asset : asset_amounts) {
-                sum += asset.second;
-            }
+    for (size_t i = 0; i < serie_currencies.size(); ++i) {
+        ss << "{ name: '" << serie_currencies[i] << "',";
+        ss << "data: [";
 
-            ss << "[Date.UTC(" << date.year() << "," << date.month().value - 1 << "," << date.day() << ") ," << budget::to_flat_string(sum) << "],";
-        }
+        add_asset_serie(ss, series, i);
 
         ss << "]},";
     }
@@ -2367,28 +2511,10 @@ void portfolio_currency_page(const httplib::Request& req, httplib::Response& res
     ss2 << "colorByPoint: true,";
     ss2 << "data: [";
 
-    for (auto& currency : currencies) {
-        ss2 << "{ name: '" << currency << "',";
+    for (size_t i = 0; i < serie_currencies.size(); ++i) {
+        ss2 << "{ name: '" << serie_currencies[i] << "',";
         ss2 << "y: ";
-
-        std::map<size_t, budget::money> asset_amounts;
-
-        for (auto& asset_value : sorted_asset_values) {
-            auto& asset = get_asset(asset_value.asset_id);
-
-            if (asset.currency == currency && asset.portfolio) {
-                asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(asset.currency);
-            }
-        }
-
-        budget::money sum;
-
-        for (auto& asset : asset_amounts) {
-            sum += asset.second;
-        }
-
-        ss2 << budget::to_flat_string(sum);
-
+        ss2 << budget::to_flat_string(last_asset_value(series, i));
         ss2 << "},";
     }
 
@@ -2424,33 +2550,8 @@ void portfolio_graph_page(const httplib::Request& req, httplib::Response& res) {
     ss << "{ name: 'Portfolio',";
     ss << "data: [";
 
-    std::map<size_t, budget::money> asset_amounts;
-
-    auto sorted_asset_values = all_sorted_asset_values();
-
-    auto it  = sorted_asset_values.begin();
-    auto end = sorted_asset_values.end();
-
-    while (it != end) {
-        auto date = it->set_date;
-
-        while (it->set_date == date) {
-            auto& asset = get_asset(it->asset_id);
-
-            if (asset.portfolio) {
-                asset_amounts[it->asset_id] = it->amount * exchange_rate(asset.currency);
-            }
-
-            ++it;
-        }
-
-        budget::money sum;
-
-        for (auto& asset : asset_amounts) {
-            sum += asset.second;
-        }
-
-        ss << "[Date.UTC(" << date.year() << "," << date.month().value - 1 << "," << date.day() << ") ," << budget::to_flat_string(sum) << "],";
+    for (auto& point : *net_worth_timeline()) {
+        add_chart_point(ss, point.date, point.portfolio);
     }
 
     ss << "]},";
@@ -2756,52 +2857,15 @@ void net_worth_allocation_page(const httplib::Request& req, httplib::Response& r
 
     ss << "series: [";
 
-    auto sorted_asset_values = all_sorted_asset_values();
+    auto series = compute_asset_series(names.size(), [](const budget::asset& asset, size_t serie) {
+        return asset_class_weight(asset, serie);
+    });
 
-    for(size_t i = 0; i < names.size(); ++i){
+    for (size_t i = 0; i < names.size(); ++i) {
         ss << "{ name: '" << names[i] << "',";
         ss << "data: [";
 
-        std::map<size_t, budget::money> asset_amounts;
-
-        auto it  = sorted_asset_values.begin();
-        auto end = sorted_asset_values.end();
-
-        while (it != end) {
-            auto date = it->set_date;
-
-            while (it->set_date == date) {
-                auto& asset = get_asset(it->asset_id);
-
-                auto amount = it->amount * exchange_rate(asset.currency);
-
-                if(i == 0 && asset.int_stocks){
-                    asset_amounts[it->asset_id] = amount * (float(asset.int_stocks) / 100.0f);
-                }
-
-                if(i == 1 && asset.dom_stocks){
-                    asset_amounts[it->asset_id] = amount * (float(asset.dom_stocks) / 100.0f);
-                }
-
-                if(i == 2 && asset.bonds){
-                    asset_amounts[it->asset_id] = amount * (float(asset.bonds) / 100.0f);
-                }
-
-                if(i == 3 && asset.cash){
-                    asset_amounts[it->asset_id] = amount * (float(asset.cash) / 100.0f);
-                }
-
-                ++it;
-            }
-
-            budget::money sum;
-
-            for (auto& asset : asset_amounts) {
-                sum += asset.second;
-            }
-
-            ss << "[Date.UTC(" << date.year() << "," << date.month().value - 1 << "," << date.day() << ") ," << budget::to_flat_string(sum) << "],";
-        }
+        add_asset_serie(ss, series, i);
 
         ss << "]},";
     }
@@ -2822,42 +2886,10 @@ void net_worth_allocation_page(const httplib::Request& req, httplib::Response& r
     ss2 << "colorByPoint: true,";
     ss2 << "data: [";
 
-    for(size_t i = 0; i < names.size(); ++i){
+    for (size_t i = 0; i < names.size(); ++i) {
         ss2 << "{ name: '" << names[i] << "',";
         ss2 << "y: ";
-
-        std::map<size_t, budget::money> asset_amounts;
-
-        for (auto& asset_value : sorted_asset_values) {
-            auto& asset = get_asset(asset_value.asset_id);
-
-            auto amount = asset_value.amount * exchange_rate(asset.currency);
-
-            if(i == 0 && asset.int_stocks){
-                asset_amounts[asset_value.asset_id] = amount * (float(asset.int_stocks) / 100.0f);
-            }
-
-            if(i == 1 && asset.dom_stocks){
-                asset_amounts[asset_value.asset_id] = amount * (float(asset.dom_stocks) / 100.0f);
-            }
-
-            if(i == 2 && asset.bonds){
-                asset_amounts[asset_value.asset_id] = amount * (float(asset.bonds) / 100.0f);
-            }
-
-            if(i == 3 && asset.cash){
-                asset_amounts[asset_value.asset_id] = amount * (float(asset.cash) / 100.0f);
-            }
-        }
-
-        budget::money sum;
-
-        for (auto& asset : asset_amounts) {
-            sum += asset.second;
-        }
-
-        ss2 << budget::to_flat_string(sum);
-
+        ss2 << budget::to_flat_string(last_asset_value(series, i));
         ss2 << "},";
     }
 
@@ -2891,54 +2923,15 @@ void portfolio_allocation_page(const httplib::Request& req, httplib::Response& r
 
     ss << "series: [";
 
-    auto sorted_asset_values = all_sorted_asset_values();
+    auto series = compute_asset_series(names.size(), [](const budget::asset& asset, size_t serie) {
+        return asset.portfolio ? asset_class_weight(asset, serie) : 0.0f;
+    });
 
-    for(size_t i = 0; i < names.size(); ++i){
+    for (size_t i = 0; i < names.size(); ++i) {
         ss << "{ name: '" << names[i] << "',";
         ss << "data: [";
 
-        std::map<size_t, budget::money> asset_amounts;
-
-        auto it  = sorted_asset_values.begin();
-        auto end = sorted_asset_values.end();
-
-        while (it != end) {
-            auto date = it->set_date;
-
-            while (it->set_date == date) {
-                auto& asset = get_asset(it->asset_id);
-
-                if(asset.portfolio){
-                    auto amount = it->amount * exchange_rate(asset.currency);
-
-                    if(i == 0 && asset.int_stocks){
-                        asset_amounts[it->asset_id] = amount * (float(asset.int_stocks) / 100.0f);
-                    }
-
-                    if(i == 1 && asset.dom_stocks){
-                        asset_amounts[it->asset_id] = amount * (float(asset.dom_stocks) / 100.0f);
-                    }
-
-                    if(i == 2 && asset.bonds){
-                        asset_amounts[it->asset_id] = amount * (float(asset.bonds) / 100.0f);
-                    }
-
-                    if(i == 3 && asset.cash){
-                        asset_amounts[it->asset_id] = amount * (float(asset.cash) / 100.0f);
-                    }
-                }
-
-                ++it;
-            }
-
-            budget::money sum;
-
-            for (auto& asset : asset_amounts) {
-                sum += asset.second;
-            }
-
-            ss << "[Date.UTC(" << date.year() << "," << date.month().value - 1 << "," << date.day() << ") ," << budget::to_flat_string(sum) << "],";
-        }
+        add_asset_serie(ss, series, i);
 
         ss << "]},";
     }
@@ -2959,44 +2952,10 @@ void portfolio_allocation_page(const httplib::Request& req, httplib::Response& r
     ss2 << "colorByPoint: true,";
     ss2 << "data: [";
 
-    for(size_t i = 0; i < names.size(); ++i){
+    for (size_t i = 0; i < names.size(); ++i) {
         ss2 << "{ name: '" << names[i] << "',";
         ss2 << "y: ";
-
-        std::map<size_t, budget::money> asset_amounts;
-
-        for (auto& asset_value : sorted_asset_values) {
-            auto& asset = get_asset(asset_value.asset_id);
-
-            if(asset.portfolio){
-                auto amount = asset_value.amount * exchange_rate(asset.currency);
-
-                if(i == 0 && asset.int_stocks){
-                    asset_amounts[asset_value.asset_id] = amount * (float(asset.int_stocks) / 100.0f);
-                }
-
-                if(i == 1 && asset.dom_stocks){
-                    asset_amounts[asset_value.asset_id] = amount * (float(asset.dom_stocks) / 100.0f);
-                }
-
-                if(i == 2 && asset.bonds){
-                    asset_amounts[asset_value.asset_id] = amount * (float(asset.bonds) / 100.0f);
-                }
-
-                if(i == 3 && asset.cash){
-                    asset_amounts[asset_value.asset_id] = amount * (float(asset.cash) / 100.0f);
-                }
-            }
-        }
-
-        budget::money sum;
-
-        for (auto& asset : asset_amounts) {
-            sum += asset.second;
-        }
-
-        ss2 << budget::to_flat_string(sum);
-
+        ss2 << budget::to_flat_string(last_asset_value(series, i));
         ss2 << "},";
     }
 
@@ -3034,36 +2993,17 @@ void net_worth_currency_page(const httplib::Request& req, httplib::Response& res
 
     ss << "series: [";
 
-    auto sorted_asset_values = all_sorted_asset_values();
-
-    for (auto& currency : currencies) {
-        ss << "{ name: '" << currency << "',";
-        ss << "data: [";
+    std::vector<std::string> serie_currencies(currencies.begin(), currencies.end());
 
-        std::map<size_t, budget::money> asset_amounts;
-
-        auto it  = sorted_asset_values.begin();
-        auto end = sorted_asset_values.end();
-
-        while (it != end) {
-            auto date = it->set_date;
-
-            while (it->set_date == date) {
-                if (get_asset(it->asset_id).currency == currency) {
-                    asset_amounts[it->asset_id] = it->amount * exchange_rate(get_asset(it->asset_id).currency);
-                }
-
-                ++it;
-            }
-
-            budget::money sum;
+    auto series = compute_asset_series(serie_currencies.size(), [&serie_currencies](const budget::asset& asset, size_t serie) {
+        return asset.currency == serie_currencies[serie] ? 1.0f : 0.0f;
+    });
 
-            for (auto& asset : asset_amounts) {
-                sum += asset.second;
-            }
+    for (size_t i = 0; i < serie_currencies.size(); ++i) {
+        ss << "{ name: '" << serie_currencies[i] << "',";
+        ss << "data: [";
 
-            ss << "[Date.UTC(" << date.year() << "," << date.month().value - 1 << "," << date.day() << ") ," << budget::to_flat_string(sum) << "],";
-        }
+        add_asset_serie(ss, series, i);
 
         ss << "]},";
     }
@@ -3084,26 +3024,10 @@ void net_worth_currency_page(const httplib::Request& req, httplib::Response& res
     ss2 << "colorByPoint: true,";
     ss2 << "data: [";
 
-    for (auto& currency : currencies) {
-        ss2 << "{ name: '" << currency << "',";
+    for (size_t i = 0; i < serie_currencies.size(); ++i) {
+        ss2 << "{ name: '" << serie_currencies[i] << "',";
         ss2 << "y: ";
-
-        std::map<size_t, budget::money> asset_amounts;
-
-        for (auto& asset_value : sorted_asset_values) {
-            if (get_asset(asset_value.asset_id).currency == currency) {
-                asset_amounts[asset_value.asset_id] = asset_value.amount * exchange_rate(get_asset(asset_value.asset_id).currency);
-            }
-        }
-
-        budget::money sum;
-
-        for (auto& asset : asset_amounts) {
-            sum += asset.second;
-        }
-
-        ss2 << budget::to_flat_string(sum);
-
+        ss2 << budget::to_flat_string(last_asset_value(series, i));
         ss2 << "},";
     }
 
@@ -3381,6 +3305,27 @@ void retirement_status_page(const httplib::Request& req, httplib::Response& res)
     page_end(content_stream, req, res);
 }
 
+void retirement_simulation_page(const httplib::Request& req, httplib::Response& res) {
+    std::stringstream content_stream;
+    if (!page_start(req, res, content_stream, "Retirement simulation")) {
+        return;
+    }
+
+    budget::html_writer w(content_stream);
+
+    w << title_begin << "Retirement simulation" << title_end;
+
+    if(!internal_config_contains("withdrawal_rate") || !internal_config_contains("expected_roi")){
+        display_error_message(w, "Not enough information, please configure Retirement Options first");
+        page_end(content_stream, req, res);
+        return;
+    }
+
+    budget::retirement_simulation(w);
+
+    page_end(content_stream, req, res);
+}
+
 void retirement_configure_page(const httplib::Request& req, httplib::Response& res) {
     std::stringstream content_stream;
     if (!page_start(req, res, content_stream, "Retirement configure")) {
@@ -3405,6 +3350,12 @@ void retirement_configure_page(const httplib::Request& req, httplib::Response& r
         add_percent_picker(w, "Annual Return [%]", "input_roi", to_number<double>(internal_config_value("expected_roi")));
     }
 
+    if (!internal_config_contains("return_volatility")) {
+        add_percent_picker(w, "Annual Return Volatility [%]", "input_volatility", 15.0);
+    } else {
+        add_percent_picker(w, "Annual Return Volatility [%]", "input_volatility", to_number<double>(internal_config_value("return_volatility")));
+    }
+
     form_end(w);
 
     page_end(content_stream, req, res);
@@ -3452,6 +3403,18 @@ void wishes_estimate_page(const httplib::Request& req, httplib::Response& res) {
     page_end(content_stream, req, res);
 }
 
+void wishes_plan_page(const httplib::Request& req, httplib::Response& res) {
+    std::stringstream content_stream;
+    if (!page_start(req, res, content_stream, "Wishes Plan")) {
+        return;
+    }
+
+    budget::html_writer w(content_stream);
+    budget::plan_wishes(w);
+
+    page_end(content_stream, req, res);
+}
+
 void add_wishes_page(const httplib::Request& req, httplib::Response& res) {
     std::stringstream content_stream;
     if (!page_start(req, res, content_stream, "New Wish")) {
@@ -3700,101 +3663,103 @@ void edit_recurrings_page(const httplib::Request& req, httplib::Response& res) {
 
 void budget::load_pages(httplib::Server& server) {
     // Declare all the pages
-    server.get("/", &index_page);
-
-    server.get("/overview/year/", &overview_year_page);
-    server.get(R"(/overview/year/(\d+)/)", &overview_year_page);
-    server.get("/overview/", &overview_page);
-    server.get(R"(/overview/(\d+)/(\d+)/)", &overview_page);
-    server.get("/overview/aggregate/year/", &overview_aggregate_year_page);
-    server.get(R"(/overview/aggregate/year/(\d+)/)", &overview_aggregate_year_page);
-    server.get("/overview/aggregate/month/", &overview_aggregate_month_page);
-    server.get(R"(/overview/aggregate/month/(\d+)/(\d+)/)", &overview_aggregate_month_page);
-    server.get("/overview/aggregate/all/", &overview_aggregate_all_page);
-    server.get("/overview/savings/time/", &time_graph_savings_rate_page);
-
-    server.get("/report/", &report_page);
-
-    server.get("/accounts/", &accounts_page);
-    server.get("/accounts/all/", &all_accounts_page);
-    server.get("/accounts/add/", &add_accounts_page);
-    server.post("/accounts/edit/", &edit_accounts_page);
-    server.get("/accounts/archive/month/", &archive_accounts_month_page);
-    server.get("/accounts/archive/year/", &archive_accounts_year_page);
-
-    server.get(R"(/expenses/(\d+)/(\d+)/)", &expenses_page);
-    server.get("/expenses/", &expenses_page);
-    server.get("/expenses/search/", &search_expenses_page);
-
-    server.get(R"(/expenses/breakdown/month/(\d+)/(\d+)/)", &month_breakdown_expenses_page);
-    server.get("/expenses/breakdown/month/", &month_breakdown_expenses_page);
-
-    server.get(R"(/expenses/breakdown/year/(\d+)/)", &year_breakdown_expenses_page);
-    server.get("/expenses/breakdown/year/", &year_breakdown_expenses_page);
-
-    server.get("/expenses/time/", &time_graph_expenses_page);
-    server.get("/expenses/all/", &all_expenses_page);
-    server.get("/expenses/add/", &add_expenses_page);
-    server.post("/expenses/edit/", &edit_expenses_page);
-
-    server.get(R"(/earnings/(\d+)/(\d+)/)", &earnings_page);
-    server.get("/earnings/", &earnings_page);
-
-    server.get("/earnings/time/", &time_graph_earnings_page);
-    server.get("/income/time/", &time_graph_income_page);
-    server.get("/earnings/all/", &all_earnings_page);
-    server.get("/earnings/add/", &add_earnings_page);
-    server.post("/earnings/edit/", &edit_earnings_page);
-
-    server.get("/portfolio/status/", &portfolio_status_page);
-    server.get("/portfolio/graph/", &portfolio_graph_page);
-    server.get("/portfolio/currency/", &portfolio_currency_page);
-    server.get("/portfolio/allocation/", &portfolio_allocation_page);
-    server.get("/rebalance/", &rebalance_page);
-    server.get("/assets/", &assets_page);
-    server.get("/net_worth/status/", &net_worth_status_page);
-    server.get("/net_worth/status/small/", &net_worth_small_status_page); // Not in the menu for now
-    server.get("/net_worth/graph/", &net_worth_graph_page);
-    server.get("/net_worth/currency/", &net_worth_currency_page);
-    server.get("/net_worth/allocation/", &net_worth_allocation_page);
-    server.get("/assets/add/", &add_assets_page);
-    server.post("/assets/edit/", &edit_assets_page);
-
-    server.get("/asset_values/list/", &list_asset_values_page);
-    server.get("/asset_values/add/", &add_asset_values_page);
-    server.get("/asset_values/batch/full/", &full_batch_asset_values_page);
-    server.get("/asset_values/batch/current/", &current_batch_asset_values_page);
-    server.post("/asset_values/edit/", &edit_asset_values_page);
-
-    server.get("/objectives/list/", &list_objectives_page);
-    server.get("/objectives/status/", &status_objectives_page);
-    server.get("/objectives/add/", &add_objectives_page);
-    server.post("/objectives/edit/", &edit_objectives_page);
-
-    server.get("/wishes/list/", &wishes_list_page);
-    server.get("/wishes/status/", &wishes_status_page);
-    server.get("/wishes/estimate/", &wishes_estimate_page);
-    server.get("/wishes/add/", &add_wishes_page);
-    server.post("/wishes/edit/", &edit_wishes_page);
-
-    server.get("/retirement/status/", &retirement_status_page);
-    server.get("/retirement/configure/", &retirement_configure_page);
-    server.get("/retirement/fi/", &retirement_fi_ratio_over_time);
-
-    server.get("/recurrings/list/", &recurrings_list_page);
-    server.get("/recurrings/add/", &add_recurrings_page);
-    server.post("/recurrings/edit/", &edit_recurrings_page);
-
-    server.get("/debts/list/", &budget::list_debts_page);
-    server.get("/debts/all/", &budget::all_debts_page);
-    server.get("/debts/add/", &budget::add_debts_page);
-    server.post("/debts/edit/", &budget::edit_debts_page);
-
-    server.get("/fortunes/graph/", &graph_fortunes_page);
-    server.get("/fortunes/status/", &status_fortunes_page);
-    server.get("/fortunes/list/", &list_fortunes_page);
-    server.get("/fortunes/add/", &add_fortunes_page);
-    server.post("/fortunes/edit/", &edit_fortunes_page);
+    server.get("/", cached(&index_page, all_data));
+
+    server.get("/overview/year/", cached(&overview_year_page, budget_data));
+    server.get(R"(/overview/year/(\d+)/)", cached(&overview_year_page, budget_data));
+    server.get("/overview/", cached(&overview_page, budget_data));
+    server.get(R"(/overview/(\d+)/(\d+)/)", cached(&overview_page, budget_data));
+    server.get("/overview/aggregate/year/", cached(&overview_aggregate_year_page, budget_data));
+    server.get(R"(/overview/aggregate/year/(\d+)/)", cached(&overview_aggregate_year_page, budget_data));
+    server.get("/overview/aggregate/month/", cached(&overview_aggregate_month_page, budget_data));
+    server.get(R"(/overview/aggregate/month/(\d+)/(\d+)/)", cached(&overview_aggregate_month_page, budget_data));
+    server.get("/overview/aggregate/all/", cached(&overview_aggregate_all_page, budget_data));
+    server.get("/overview/savings/time/", cached(&time_graph_savings_rate_page, budget_data));
+
+    server.get("/report/", cached(&report_page, budget_data));
+
+    server.get("/accounts/", read_locked(&accounts_page));
+    server.get("/accounts/all/", read_locked(&all_accounts_page));
+    server.get("/accounts/add/", read_locked(&add_accounts_page));
+    server.post("/accounts/edit/", read_locked(&edit_accounts_page));
+    server.get("/accounts/archive/month/", read_locked(&archive_accounts_month_page));
+    server.get("/accounts/archive/year/", read_locked(&archive_accounts_year_page));
+
+    server.get(R"(/expenses/(\d+)/(\d+)/)", read_locked(&expenses_page));
+    server.get("/expenses/", read_locked(&expenses_page));
+    server.get("/expenses/search/", read_locked(&search_expenses_page));
+
+    server.get(R"(/expenses/breakdown/month/(\d+)/(\d+)/)", cached(&month_breakdown_expenses_page, budget_data));
+    server.get("/expenses/breakdown/month/", cached(&month_breakdown_expenses_page, budget_data));
+
+    server.get(R"(/expenses/breakdown/year/(\d+)/)", cached(&year_breakdown_expenses_page, budget_data));
+    server.get("/expenses/breakdown/year/", cached(&year_breakdown_expenses_page, budget_data));
+
+    server.get("/expenses/time/", cached(&time_graph_expenses_page, budget_data));
+    server.get("/expenses/all/", read_locked(&all_expenses_page));
+    server.get("/expenses/add/", read_locked(&add_expenses_page));
+    server.post("/expenses/edit/", read_locked(&edit_expenses_page));
+
+    server.get(R"(/earnings/(\d+)/(\d+)/)", read_locked(&earnings_page));
+    server.get("/earnings/", read_locked(&earnings_page));
+
+    server.get("/earnings/time/", cached(&time_graph_earnings_page, budget_data));
+    server.get("/income/time/", cached(&time_graph_income_page, budget_data));
+    server.get("/earnings/all/", read_locked(&all_earnings_page));
+    server.get("/earnings/add/", read_locked(&add_earnings_page));
+    server.post("/earnings/edit/", read_locked(&edit_earnings_page));
+
+    server.get("/portfolio/status/", cached(&portfolio_status_page, assets_data));
+    server.get("/portfolio/graph/", cached(&portfolio_graph_page, assets_data));
+    server.get("/portfolio/currency/", cached(&portfolio_currency_page, assets_data));
+    server.get("/portfolio/allocation/", cached(&portfolio_allocation_page, assets_data));
+    server.get("/rebalance/", cached(&rebalance_page, assets_data));
+    server.get("/assets/", read_locked(&assets_page));
+    server.get("/net_worth/status/", cached(&net_worth_status_page, assets_data));
+    server.get("/net_worth/status/small/", cached(&net_worth_small_status_page, assets_data)); // Not in the menu for now
+    server.get("/net_worth/graph/", cached(&net_worth_graph_page, assets_data));
+    server.get("/net_worth/currency/", cached(&net_worth_currency_page, assets_data));
+    server.get("/net_worth/allocation/", cached(&net_worth_allocation_page, assets_data));
+    server.get("/assets/add/", read_locked(&add_assets_page));
+    server.post("/assets/edit/", read_locked(&edit_assets_page));
+
+    server.get("/asset_values/list/", read_locked(&list_asset_values_page));
+    server.get("/asset_values/add/", read_locked(&add_asset_values_page));
+    server.get("/asset_values/batch/full/", read_locked(&full_batch_asset_values_page));
+    server.get("/asset_values/batch/current/", read_locked(&current_batch_asset_values_page));
+    server.post("/asset_values/edit/", read_locked(&edit_asset_values_page));
+
+    server.get("/objectives/list/", read_locked(&list_objectives_page));
+    server.get("/objectives/status/", cached(&status_objectives_page, all_data));
+    server.get("/objectives/add/", read_locked(&add_objectives_page));
+    server.post("/objectives/edit/", read_locked(&edit_objectives_page));
+
+    server.get("/wishes/list/", read_locked(&wishes_list_page));
+    server.get("/wishes/status/", cached(&wishes_status_page, all_data));
+    server.get("/wishes/estimate/", cached(&wishes_estimate_page, all_data));
+    server.get("/wishes/plan/", cached(&wishes_plan_page, all_data));
+    server.get("/wishes/add/", read_locked(&add_wishes_page));
+    server.post("/wishes/edit/", read_locked(&edit_wishes_page));
+
+    server.get("/retirement/status/", read_locked(&retirement_status_page));
+    server.get("/retirement/configure/", read_locked(&retirement_configure_page));
+    server.get("/retirement/fi/", read_locked(&retirement_fi_ratio_over_time));
+    server.get("/retirement/simulation/", read_locked(&retirement_simulation_page));
+
+    server.get("/recurrings/list/", read_locked(&recurrings_list_page));
+    server.get("/recurrings/add/", read_locked(&add_recurrings_page));
+    server.post("/recurrings/edit/", read_locked(&edit_recurrings_page));
+
+    server.get("/debts/list/", read_locked(&budget::list_debts_page));
+    server.get("/debts/all/", read_locked(&budget::all_debts_page));
+    server.get("/debts/add/", read_locked(&budget::add_debts_page));
+    server.post("/debts/edit/", read_locked(&budget::edit_debts_page));
+
+    server.get("/fortunes/graph/", cached(&graph_fortunes_page, fortunes_data));
+    server.get("/fortunes/status/", cached(&status_fortunes_page, fortunes_data));
+    server.get("/fortunes/list/", read_locked(&list_fortunes_page));
+    server.get("/fortunes/add/", read_locked(&add_fortunes_page));
+    server.post("/fortunes/edit/", read_locked(&edit_fortunes_page));
 
     // Handle error
 
@@ -3825,49 +3790,8 @@ void budget::load_pages(httplib::Server& server) {
 bool budget::page_start(const httplib::Request& req, httplib::Response& res, std::stringstream& content_stream, const std::string& title) {
     content_stream.imbue(std::locale("C"));
 
-    if (is_secure()) {
-        if (req.has_header("Authorization")) {
-            auto authorization = req.get_header_value("Authorization");
-
-            if (authorization.substr(0, 6) != "Basic ") {
-                res.status = 401;
-                res.set_header("WWW-Authenticate", "Basic realm=\"budgetwarrior\"");
-
-                return false;
-            }
-
-            auto sub_authorization = authorization.substr(6, authorization.size());
-            auto decoded           = base64_decode(sub_authorization);
-
-            if (decoded.find(':') == std::string::npos) {
-                res.status = 401;
-                res.set_header("WWW-Authenticate", "Basic realm=\"budgetwarrior\"");
-
-                return false;
-            }
-
-            auto username = decoded.substr(0, decoded.find(':'));
-            auto password = decoded.substr(decoded.find(':') + 1, decoded.size());
-
-            if (username != get_web_user()) {
-                res.status = 401;
-                res.set_header("WWW-Authenticate", "Basic realm=\"budgetwarrior\"");
-
-                return false;
-            }
-
-            if (password != get_web_password()) {
-                res.status = 401;
-                res.set_header("WWW-Authenticate", "Basic realm=\"budgetwarrior\"");
-
-                return false;
-            }
-        } else {
-            res.status = 401;
-            res.set_header("WWW-Authenticate", "Basic realm=\"budgetwarrior\"");
-
-            return false;
-        }
+    if (!authenticate(req, res)) {
+        return false;
     }
 
     content_stream << header(title);
@@ -3884,11 +3808,10 @@ void budget::page_end(std::stringstream& content_stream, const httplib::Request&
     w.load_deferred_scripts();
     w << "</body></html>";
 
-    auto result = content_stream.str();
-
-    filter_html(result, req);
+    // The page is filtered directly into the body of the response
+    filter_html(content_stream.str(), req, res.body);
 
-    res.set_content(result, "text/html");
+    res.set_header("Content-Type", "text/html");
 }
 
 void budget::make_tables_sortable(budget::html_writer& w){
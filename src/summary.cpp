@@ -23,6 +23,7 @@
 #include "config.hpp"
 #include "utils.hpp"
 #include "writer.hpp"
+#include "loader.hpp"
 
 using namespace budget;
 
@@ -152,11 +153,10 @@ void month_overview() {
 constexpr const std::array<std::pair<const char*, const char*>, 1> budget::module_traits<budget::summary_module>::aliases;
 
 void budget::summary_module::load() {
-    load_accounts();
-    load_expenses();
-    load_earnings();
-    load_objectives();
-    load_fortunes();
+    load_concurrently({
+        load_accounts, load_expenses, load_earnings, load_objectives,
+        load_fortunes
+    });
 }
 
 void budget::summary_module::handle(std::vector<std::string>& args) {
@@ -67,14 +67,48 @@ bool budget::folder_exists(const std::string& name){
 }
 
 std::vector<std::string>& budget::split(const std::string& s, char delim, std::vector<std::string>& elems) {
-    std::stringstream ss(s);
-    std::string item;
-    while (std::getline(ss, item, delim)) {
-        elems.push_back(item);
+    size_t first = 0;
+
+    while (first < s.size()) {
+        auto last = s.find(delim, first);
+
+        if (last == std::string::npos) {
+            last = s.size();
+        }
+
+        elems.emplace_back(s, first, last - first);
+
+        first = last + 1;
     }
+
     return elems;
 }
 
+void budget::tokenize(const std::string& s, char delim, std::vector<std::string>& tokens) {
+    size_t count = 0;
+    size_t first = 0;
+
+    while (first < s.size()) {
+        auto last = s.find(delim, first);
+
+        if (last == std::string::npos) {
+            last = s.size();
+        }
+
+        if (count < tokens.size()) {
+            tokens[count].assign(s, first, last - first);
+        } else {
+            tokens.emplace_back(s, first, last - first);
+        }
+
+        ++count;
+
+        first = last + 1;
+    }
+
+    tokens.resize(count);
+}
+
 std::vector<std::string> budget::split(const std::string& s, char delim) {
     std::vector<std::string> elems;
     split(s, delim, elems);
@@ -8,6 +8,8 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <limits>
+#include <algorithm>
 
 #include "cpp_utils/string.hpp"
 
@@ -28,6 +30,7 @@
 #include "compute.hpp"
 #include "console.hpp"
 #include "writer.hpp"
+#include "loader.hpp"
 
 using namespace budget;
 
@@ -35,6 +38,136 @@ namespace {
 
 static data_handler<wish> wishes { "wishes", "wishes.data" };
 
+/*!
+ * \brief Indicates, for each of the statuses, if all the objectives of the
+ * period are still fulfilled after the expense.
+ */
+std::vector<bool> objectives_fulfilled(const std::vector<budget::compiled_objective>& objectives, budget::objective_period period,
+                                       const std::vector<budget::status>& statuses, budget::money expense){
+    std::vector<budget::status> after;
+
+    for (auto& status : statuses) {
+        after.push_back(status.add_expense(expense));
+    }
+
+    std::vector<bool> fulfilled(statuses.size(), true);
+
+    for (auto& objective : objectives) {
+        if (objective.period == period) {
+            auto successes = budget::compute_successes(objective, after);
+
+            for (size_t i = 0; i < successes.size(); ++i) {
+                if (successes[i] < 100) {
+                    fulfilled[i] = false;
+                }
+            }
+        }
+    }
+
+    return fulfilled;
+}
+
+constexpr size_t projection_months = 24;
+constexpr size_t never_affordable  = std::numeric_limits<size_t>::max();
+
+/*!
+ * \brief The month and year statuses of the next months, on which the
+ * wishes are planned.
+ */
+struct wish_planner {
+    std::vector<budget::compiled_objective> objectives;
+    std::vector<budget::date> days;
+    std::vector<budget::status> month_statuses;
+    std::vector<budget::status> year_statuses;
+    std::vector<budget::money> fortunes;
+
+    wish_planner(budget::date today, budget::money fortune) : objectives(budget::compiled_objectives()) {
+        for (size_t i = 0; i < projection_months; ++i) {
+            auto day = today + budget::months(i);
+
+            days.push_back(day);
+            month_statuses.push_back(budget::compute_month_status(day.year(), day.month()));
+            year_statuses.push_back(budget::compute_year_status(day.year(), day.month()));
+            fortunes.push_back(fortune);
+        }
+    }
+
+    /*!
+     * \brief Returns the first month where the wish can be bought without
+     * breaking the objectives, or never_affordable.
+     *
+     * Once wishes have been bought, buying another one lowers the cash of
+     * all the next months and the year balance of the next months of the
+     * same year, which may carry these wishes, so these months are checked
+     * as well.
+     */
+    size_t first_month(const budget::wish& wish, bool year_objectives) const {
+        auto month_fulfilled = objectives_fulfilled(objectives, budget::objective_period::monthly, month_statuses, wish.amount);
+        auto year_fulfilled  = objectives_fulfilled(objectives, budget::objective_period::yearly, year_statuses, wish.amount);
+
+        // Indicates, for each month, if the cash stays sufficient until the
+        // end of the projection and if the year balance and objectives hold
+        // until the end of the year
+        std::vector<bool> cash_valid(days.size() + 1, true);
+        std::vector<bool> year_valid(days.size() + 1, true);
+
+        if (bought) {
+            for (size_t i = days.size(); i-- > 0;) {
+                bool same_year = i + 1 < days.size() && days[i + 1].year() == days[i].year();
+
+                cash_valid[i] = fortunes[i] >= wish.amount && cash_valid[i + 1];
+                year_valid[i] = (!year_objectives || year_fulfilled[i]) && (!same_year || (year_statuses[i + 1].balance > wish.amount && year_valid[i + 1]));
+            }
+        } else {
+            for (size_t i = 0; i < days.size(); ++i) {
+                cash_valid[i] = fortunes[i] >= wish.amount;
+                year_valid[i] = !year_objectives || year_fulfilled[i];
+            }
+        }
+
+        for (size_t i = 0; i < days.size(); ++i) {
+            if (cash_valid[i] && year_valid[i] && month_fulfilled[i] && on_balance(wish, i)) {
+                return i;
+            }
+        }
+
+        return never_affordable;
+    }
+
+    /*!
+     * \brief Buy the wish at the given month, so that the next wishes are
+     * planned with its expense
+     */
+    void buy(const budget::wish& wish, size_t month) {
+        bought = true;
+
+        month_statuses[month] = month_statuses[month].add_expense(wish.amount);
+
+        for (size_t i = month; i < days.size(); ++i) {
+            if (days[i].year() == days[month].year()) {
+                year_statuses[i] = year_statuses[i].add_expense(wish.amount);
+            }
+
+            fortunes[i] -= wish.amount;
+        }
+    }
+
+    std::string month_string(size_t month) const {
+        return days[month].month().as_short_string() + " " + to_string(days[month].year());
+    }
+
+private:
+    bool bought = false; ///< Indicates if wishes have been bought in the projection
+
+    bool on_balance(const budget::wish& wish, size_t i) const {
+        if (wish.amount >= month_statuses[i].budget) {
+            return year_statuses[i].balance > wish.amount;
+        } else {
+            return month_statuses[i].balance > wish.amount;
+        }
+    }
+};
+
 std::string wish_status(size_t v){
     switch(v){
         case 1:
@@ -102,17 +235,11 @@ std::map<std::string, std::string> budget::wish::get_params(){
 }
 
 void budget::wishes_module::load(){
-    load_expenses();
-    load_earnings();
-    load_accounts();
-
-    // Need to load both to make sure to have the correct information
-    load_assets();
-    load_fortunes();
-
-    // Need to be loaded last
-    load_objectives();
-    load_wishes();
+    // Both assets and fortunes are needed to have the correct information
+    load_concurrently({
+        load_expenses, load_earnings, load_accounts, load_assets,
+        load_fortunes, load_objectives, load_wishes
+    });
 }
 
 void budget::wishes_module::unload(){
@@ -133,6 +260,8 @@ void budget::wishes_module::handle(const std::vector<std::string>& args){
             status_wishes(w);
         } else if(subcommand == "estimate"){
             estimate_wishes(w);
+        } else if(subcommand == "plan"){
+            plan_wishes(w);
         } else if(subcommand == "add"){
             wish wish;
             wish.guid = generate_guid();
@@ -197,7 +326,7 @@ void budget::wishes_module::handle(const std::vector<std::string>& args){
 }
 
 void budget::load_wishes(){
-    wishes.load();
+    wishes.ensure_loaded();
 }
 
 void budget::save_wishes(){
@@ -238,6 +367,8 @@ void budget::operator>>(const std::vector<std::string>& parts, wish& wish){
 }
 
 std::vector<wish>& budget::all_wishes(){
+    wishes.ensure_loaded();
+
     return wishes.data;
 }
 
@@ -249,6 +380,10 @@ void budget::set_wishes_next_id(size_t next_id){
     wishes.next_id = next_id;
 }
 
+size_t budget::wishes_generation(){
+    return wishes.generation();
+}
+
 void budget::migrate_wishes_2_to_3(){
     wishes.load([](const std::vector<std::string>& parts, wish& wish){
         wish.id = to_number<size_t>(parts[0]);
@@ -345,6 +480,15 @@ void budget::status_wishes(budget::writer& w){
 
     auto fortune_amount = cash_for_wishes();
 
+    // The success of the objectives does not depend on the wish
+    auto objectives = compiled_objectives();
+
+    std::vector<int> successes_before;
+
+    for(auto& objective : objectives){
+        successes_before.push_back(objective.success(objective.period == objective_period::yearly ? year_status : month_status));
+    }
+
     budget::money total_amount;
 
     for(auto& wish : wishes.data){
@@ -360,23 +504,23 @@ void budget::status_wishes(budget::writer& w){
         bool month_objective = true;
         bool year_objective = true;
 
-        for(auto& objective : all_objectives()){
-            if(objective.type == "monthly"){
-                auto success_before = budget::compute_success(month_status, objective);
-                auto success_after = budget::compute_success(month_status.add_expense(wish.amount), objective);
+        for(size_t i = 0; i < objectives.size(); ++i){
+            auto& objective = objectives[i];
 
-                if(success_before >= 100 && success_after < 100){
+            if(objective.period == objective_period::monthly){
+                auto success_after = objective.success(month_status.add_expense(wish.amount));
+
+                if(successes_before[i] >= 100 && success_after < 100){
                     ++monthly_breaks;
                 }
 
                 if(success_after < 100){
                     month_objective = false;
                 }
-            } else if(objective.type == "yearly"){
-                auto success_before = budget::compute_success(year_status, objective);
-                auto success_after = budget::compute_success(year_status.add_expense(wish.amount), objective);
+            } else if(objective.period == objective_period::yearly){
+                auto success_after = objective.success(year_status.add_expense(wish.amount));
 
-                if(success_before >= 100 && success_after < 100){
+                if(successes_before[i] >= 100 && success_after < 100){
                     ++yearly_breaks;
                 }
 
@@ -451,141 +595,89 @@ void budget::estimate_wishes(budget::writer& w) {
     std::vector<std::vector<std::string>> year_contents;
     std::vector<std::vector<std::string>> month_contents;
 
-    auto fortune_amount = cash_for_wishes();
-    auto today          = budget::local_day();
+    // All the wishes are estimated independently on the same projection
+    wish_planner planner(budget::local_day(), cash_for_wishes());
 
     for (auto& wish : wishes.data) {
         if (wish.paid) {
             continue;
         }
 
-        bool ok = false;
-
-        std::string status;
-
-        for (size_t i = 0; i < 24 && !ok; ++i) {
-            auto day = today + months(i);
-
-            auto month_status = budget::compute_month_status(day.year(), day.month());
-            auto year_status  = budget::compute_year_status(day.year(), day.month());
+        auto year_month = planner.first_month(wish, true);
+        auto month      = planner.first_month(wish, false);
 
-            size_t monthly_breaks = 0;
-            size_t yearly_breaks  = 0;
+        std::string year_status  = "You should wait until next year to buy this";
+        std::string month_status = "You should wait a very long time to buy this";
 
-            bool month_objective = true;
-            bool year_objective  = true;
+        if (year_month != never_affordable) {
+            year_status = planner.month_string(year_month);
+        }
 
-            for (auto& objective : all_objectives()) {
-                if (objective.type == "monthly") {
-                    auto success_before = budget::compute_success(month_status, objective);
-                    auto success_after  = budget::compute_success(month_status.add_expense(wish.amount), objective);
+        if (month != never_affordable) {
+            month_status = planner.month_string(month);
+        }
 
-                    if (success_before >= 100 && success_after < 100) {
-                        ++monthly_breaks;
-                    }
+        year_contents.push_back({to_string(wish.id), wish.name, to_string(wish.amount), year_status, "::edit::wishes::" + to_string(wish.id)});
+        month_contents.push_back({to_string(wish.id), wish.name, to_string(wish.amount), month_status, "::edit::wishes::" + to_string(wish.id)});
+    }
 
-                    if (success_after < 100) {
-                        month_objective = false;
-                    }
-                } else if (objective.type == "yearly") {
-                    auto success_before = budget::compute_success(year_status, objective);
-                    auto success_after  = budget::compute_success(year_status.add_expense(wish.amount), objective);
+    w << title_begin << "Time to buy (with year objectives)" << title_end;
+    w.display_table(columns, year_contents);
 
-                    if (success_before >= 100 && success_after < 100) {
-                        ++yearly_breaks;
-                    }
+    w << title_begin << "Time to buy (without year objectives)" << title_end;
+    w.display_table(columns, month_contents);
+}
 
-                    if (success_after < 100) {
-                        year_objective = false;
-                    }
-                }
-            }
+void budget::plan_wishes(budget::writer& w) {
+    w << title_begin << "Wishes plan" << title_end;
 
-            if (fortune_amount >= wish.amount) {
-                if (month_objective && year_objective) {
-                    if (wish.amount >= month_status.budget) {
-                        if (year_status.balance > wish.amount) {
-                            status = day.month().as_short_string() + " " + to_string(day.year());
-                            ok     = true;
-                        }
-                    } else {
-                        if (month_status.balance > wish.amount) {
-                            status = day.month().as_short_string() + " " + to_string(day.year());
-                            ok     = true;
-                        }
-                    }
-                }
-            }
-        }
+    std::vector<const wish*> pending;
 
-        if (!ok) {
-            status = "You should wait until next year to buy this";
+    for (auto& wish : wishes.data) {
+        if (!wish.paid) {
+            pending.push_back(&wish);
         }
-
-        year_contents.push_back({to_string(wish.id), wish.name, to_string(wish.amount), status, "::edit::wishes::" + to_string(wish.id)});
     }
 
-    for (auto& wish : wishes.data) {
-        if (wish.paid) {
-            continue;
+    // The most important and urgent wishes are planned first, then the oldest
+    std::stable_sort(pending.begin(), pending.end(), [](const wish* lhs, const wish* rhs) {
+        if (lhs->importance != rhs->importance) {
+            return lhs->importance > rhs->importance;
         }
 
-        bool ok = false;
+        if (lhs->urgency != rhs->urgency) {
+            return lhs->urgency > rhs->urgency;
+        }
 
-        std::string status;
+        return lhs->date < rhs->date;
+    });
 
-        for (size_t i = 0; i < 24 && !ok; ++i) {
-            auto day          = today + months(i);
-            auto month_status = budget::compute_month_status(day.year(), day.month());
-            auto year_status  = budget::compute_year_status(day.year(), day.month());
+    wish_planner planner(budget::local_day(), cash_for_wishes());
 
-            size_t monthly_breaks = 0;
-            bool month_objective  = true;
+    std::vector<std::string> columns = {"ID", "Name", "Amount", "I", "U", "Date", "Edit"};
+    std::vector<std::vector<std::string>> contents;
 
-            for (auto& objective : all_objectives()) {
-                if (objective.type == "monthly") {
-                    auto success_before = budget::compute_success(month_status, objective);
-                    auto success_after  = budget::compute_success(month_status.add_expense(wish.amount), objective);
+    budget::money planned;
 
-                    if (success_before >= 100 && success_after < 100) {
-                        ++monthly_breaks;
-                    }
+    for (auto* wish : pending) {
+        auto month = planner.first_month(*wish, true);
 
-                    if (success_after < 100) {
-                        month_objective = false;
-                    }
-                }
-            }
+        std::string status = "::redNot in the next " + to_string(projection_months) + " months";
 
-            if (fortune_amount >= wish.amount) {
-                if (month_objective) {
-                    if (wish.amount >= month_status.budget) {
-                        if (year_status.balance > wish.amount) {
-                            status = day.month().as_short_string() + " " + to_string(day.year());
-                            ok     = true;
-                        }
-                    } else {
-                        if (month_status.balance > wish.amount) {
-                            status = day.month().as_short_string() + " " + to_string(day.year());
-                            ok     = true;
-                        }
-                    }
-                }
-            }
-        }
+        if (month != never_affordable) {
+            planner.buy(*wish, month);
+            planned += wish->amount;
 
-        if (!ok) {
-            status = "You should wait a very long time to buy this";
+            status = planner.month_string(month);
         }
 
-        month_contents.push_back({to_string(wish.id), wish.name, to_string(wish.amount), status, "::edit::wishes::" + to_string(wish.id)});
+        contents.push_back({to_string(wish->id), wish->name, to_string(wish->amount), wish_status_short(wish->importance), wish_status_short(wish->urgency), status, "::edit::wishes::" + to_string(wish->id)});
     }
 
-    w << title_begin << "Time to buy (with year objectives)" << title_end;
-    w.display_table(columns, year_contents);
+    contents.push_back({"", "", "", "", "", "", ""});
+    contents.push_back({"", "Total planned", to_string(planned), "", "", "", ""});
 
-    w << title_begin << "Time to buy (without year objectives)" << title_end;
-    w.display_table(columns, month_contents);
+    w.display_table(columns, contents, 1, {}, 0, 2);
 }
 
 bool budget::wish_exists(size_t id){
@@ -611,3 +703,7 @@ wish& budget::wish_get(size_t id) {
 void budget::add_wish(budget::wish&& wish){
     wishes.add(std::forward<budget::wish>(wish));
 }
+
+bool budget::edit_wish(wish& wish){
+    return wishes.edit(wish);
+}